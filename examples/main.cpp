@@ -1,10 +1,16 @@
 #include "quix_commands.hpp"
 #include "quix_common.hpp"
 #include "quix_descriptor.hpp"
+#include "quix_device.hpp"
+#include "quix_frame_allocator.hpp"
+#include "quix_geometry_arena.hpp"
+#include "quix_indirect.hpp"
 #include "quix_instance.hpp"
 #include "quix_pipeline.hpp"
+#include "quix_query.hpp"
 #include "quix_render_target.hpp"
 #include "quix_resource.hpp"
+#include "quix_upload.hpp"
 #include "quix_window.hpp"
 
 #define GLM_FORCE_RADIANS
@@ -81,8 +87,23 @@ int main()
         VK_MAKE_VERSION(0, 0, 1),
         WIDTH, HEIGHT);
 
+    // nothing beyond the quix baseline is required, the rest is used when the device has it
+    quix::device_features preferred_features {};
+    preferred_features.core.features.samplerAnisotropy = VK_TRUE;
+    // lets textures whose format cannot be blitted get their mips from a compute shader
+    preferred_features.core.features.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+    preferred_features.core.features.textureCompressionBC = VK_TRUE;
+    preferred_features.core.features.multiDrawIndirect = VK_TRUE;
+    preferred_features.core.features.drawIndirectFirstInstance = VK_TRUE;
+    preferred_features.vulkan12.descriptorIndexing = VK_TRUE;
+    preferred_features.vulkan12.bufferDeviceAddress = VK_TRUE;
+    preferred_features.vulkan12.drawIndirectCount = VK_TRUE;
+    preferred_features.vulkan13.synchronization2 = VK_TRUE;
+    preferred_features.vulkan13.dynamicRendering = VK_TRUE;
+    preferred_features.vulkan13.maintenance4 = VK_TRUE;
+
     instance.create_device({ VK_KHR_SWAPCHAIN_EXTENSION_NAME },
-        {});
+        quix::device_features {}, preferred_features);
     instance.create_swapchain(FRAMES_IN_FLIGHT, VK_PRESENT_MODE_FIFO_KHR, true);
 
     auto vertices = quix::create_auto_array<Vertex>(
@@ -100,33 +121,28 @@ int main()
         0, 1, 2, 2, 3, 0,
         4, 5, 6, 6, 7, 4);
 
-    auto vertex_buffer = instance.create_buffer_handle();
-    vertex_buffer.create_staged_buffer(sizeof(Vertex) * vertices.size(),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        vertices.data(),
-        &instance);
+    auto uploads = instance.create_upload_batch();
 
-    auto index_buffer = instance.create_buffer_handle();
-    index_buffer.create_staged_buffer(sizeof(uint16_t) * indices.size(),
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        indices.data(),
-        &instance);
+    // every mesh of a scene shares these two buffers, draws only differ in their offsets
+    auto geometry = instance.create_geometry_arena(sizeof(Vertex), 64 * 1024, 192 * 1024, VK_INDEX_TYPE_UINT16);
+    const auto quads = geometry.allocate(vertices.data(), vertices.size(), indices.data(), indices.size(), &uploads);
+    quix_assert(quads.has_value(), "geometry arena is full");
 
     auto image = instance.create_image_handle();
-    image.create_image_from_file("examples/img.jpg", &instance)
+    image.create_image_from_file("examples/img.jpg", &uploads)
         .create_view()
         .create_sampler(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
-    auto uniform_buffers = std::array<quix::buffer_handle, FRAMES_IN_FLIGHT> {
-        instance.create_buffer_handle(), instance.create_buffer_handle()
-    };
-    for (auto& uniform_buffer : uniform_buffers) {
-        uniform_buffer.create_uniform_buffer(sizeof(uniform_buffer_object));
-        *((uniform_buffer_object*)uniform_buffer.get_mapped_data()) = uniform_buffer_object {};
-    }
+    // one submission for all uploads, later graphics submissions are ordered after it
+    uploads.submit();
+
+    // every frame pushes its uniforms here and binds them with a dynamic offset into the same descriptor set
+    auto frame_uniforms = instance.create_frame_allocator(FRAMES_IN_FLIGHT, 64 * 1024);
+    auto draws = instance.create_indirect_draw_buffer(FRAMES_IN_FLIGHT, 1024, 0, quix::indirect_source::cpu);
 
     auto render_target = instance.create_single_pass_depth_render_target();
 
+    instance.set_pipeline_cache_path("pipeline_cache.bin");
     auto pipeline_manager = instance.get_pipeline_manager();
     auto pipeline_builder = pipeline_manager->create_pipeline_builder(&render_target);
 
@@ -140,19 +156,17 @@ int main()
     auto allocator_pool = instance.get_descriptor_allocator_pool();
     auto descriptor_set_builder = instance.get_descriptor_builder(&allocator_pool);
     auto descriptor_set_layout = descriptor_set_builder
-                                     .bind_buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+                                     .bind_buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
                                      .bind_image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
                                      .buildLayout();
 
-    std::array<VkDescriptorSet, FRAMES_IN_FLIGHT> descriptor_sets {};
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
     {
         auto image_info = image.get_descriptor_info();
         descriptor_set_builder.update_image(1, &image_info);
-        for (uint32_t index = 0; index < FRAMES_IN_FLIGHT; index++) {
-            auto buffer_info = uniform_buffers[index].get_descriptor_info();
-            descriptor_set_builder.update_buffer(0, &buffer_info);
-            descriptor_sets[index] = descriptor_set_builder.buildSet();
-        }
+        auto buffer_info = frame_uniforms.get_descriptor_info(sizeof(uniform_buffer_object));
+        descriptor_set_builder.update_buffer(0, &buffer_info);
+        descriptor_set = descriptor_set_builder.buildSet();
     }
 
     auto pipeline = pipeline_builder.add_shader_stages(shader_stages)
@@ -166,6 +180,7 @@ int main()
     auto window = instance.get_window();
     auto command_pool = instance.get_command_pool();
     auto sync_objects = instance.create_sync_objects();
+    auto profiler = instance.create_query_profiler(sync_objects.get_frames_in_flight());
 
     int current_frame = 0;
     uint32_t current_image_index = 0;
@@ -178,8 +193,6 @@ int main()
         { { 0.0f, 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } }
     };
 
-    std::array<VkBuffer, 1> vertex_buffer_array = { vertex_buffer.get_buffer() };
-    std::array<VkDeviceSize, 1> offsets = { 0 };
 
     std::chrono::high_resolution_clock clock;
     auto start_time = clock.now();
@@ -189,7 +202,7 @@ int main()
         auto cur_time = clock.now();
         float time = std::chrono::duration<float, std::chrono::seconds::period>(cur_time - start_time).count();
         uniform_buffer_main.update(time);
-        memcpy(uniform_buffers[current_frame].get_mapped_data(), &uniform_buffer_main, sizeof(uniform_buffer_main));
+        return frame_uniforms.push(uniform_buffer_main).offset;
     };
 
     while (!window->should_close()) {
@@ -202,27 +215,35 @@ int main()
         } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
             quix_error("failed to acquire swapchain image");
         }
-        sync_objects.reset_fence(current_frame);
+
+        frame_uniforms.begin_frame(current_frame);
+        draws.begin_frame(current_frame);
+        draws.add_draw(geometry.get_draw(*quads));
+        const uint32_t uniform_offset = update_uniform();
 
         command_lists[current_frame]->begin_record();
 
-        command_lists[current_frame]->begin_render_pass(render_target, pipeline, current_image_index, clear_values.data(), clear_values.size());
+        profiler.begin_frame(command_lists[current_frame].get(), current_frame);
+        {
+            auto main_pass_scope = profiler.scope(command_lists[current_frame].get(), "main pass");
 
-        vkCmdBindVertexBuffers(command_lists[current_frame]->get_cmd_buffer(), 0, vertex_buffer_array.size(), vertex_buffer_array.data(), offsets.data());
+            command_lists[current_frame]->begin_render_pass(render_target, pipeline, current_image_index, clear_values.data(), clear_values.size());
 
-        vkCmdBindIndexBuffer(command_lists[current_frame]->get_cmd_buffer(), index_buffer.get_buffer(), 0, VK_INDEX_TYPE_UINT16);
+            geometry.bind(command_lists[current_frame].get());
 
-        vkCmdBindDescriptorSets(command_lists[current_frame]->get_cmd_buffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->get_layout(), 0, 1, &descriptor_sets[current_frame], 0, nullptr);
+            command_lists[current_frame]->bind_descriptor_sets(0, &descriptor_set, 1, &uniform_offset, 1);
 
-        vkCmdDrawIndexed(command_lists[current_frame]->get_cmd_buffer(), indices.size(), 1, 0, 0, 0);
+            draws.record(command_lists[current_frame].get());
 
-        command_lists[current_frame]->end_render_pass();
+            command_lists[current_frame]->end_render_pass();
+        }
 
         command_lists[current_frame]->end_record();
 
-        update_uniform();
+        frame_uniforms.end_frame();
+        draws.end_frame();
 
-        VK_CHECK(sync_objects.submit_frame(current_frame, command_lists[current_frame].get()), "failed to submit frame");
+        sync_objects.submit_frame(current_frame, command_lists[current_frame].get());
 
         result = sync_objects.present_frame(current_frame, current_image_index);
 
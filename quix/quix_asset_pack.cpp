@@ -0,0 +1,225 @@
+#ifndef _QUIX_ASSET_PACK_CPP
+#define _QUIX_ASSET_PACK_CPP
+
+#include "quix_asset_pack.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace quix {
+
+namespace {
+
+    NODISCARD constexpr uint64_t align_up(uint64_t value, uint64_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void write_at(FILE* handle, uint64_t offset, const void* data, std::size_t size)
+    {
+        quix_assert(fseek(handle, static_cast<long>(offset), SEEK_SET) == 0, "failed to seek in pack file");
+        quix_assert(fwrite(data, 1, size, handle) == size, "failed to write pack file");
+    }
+
+    // pread may return less than asked for, e.g. when interrupted by a signal
+    void read_at(int file, uint64_t offset, void* dst, std::size_t size)
+    {
+        auto* bytes = static_cast<char*>(dst);
+        while (size > 0) {
+            const ssize_t read_size = pread(file, bytes, size, static_cast<off_t>(offset));
+            quix_assert(read_size > 0, "failed to read pack file");
+
+            bytes += read_size;
+            offset += static_cast<uint64_t>(read_size);
+            size -= static_cast<std::size_t>(read_size);
+        }
+    }
+
+} // namespace
+
+pack::entry& asset_pack_writer::add_entry(const char* name, pack::asset_type type, const void* data, VkDeviceSize size)
+{
+    const std::size_t name_length = std::strlen(name);
+    quix_assert(name_length <= pack::max_name_length, fmt::format("asset name {} is too long", name));
+
+    auto& asset = m_assets.emplace_back();
+    std::memcpy(asset.entry.name, name, name_length);
+    asset.entry.type = type;
+    asset.entry.data_size = size;
+    asset.data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+
+    return asset.entry;
+}
+
+void asset_pack_writer::add_buffer(const char* name, const void* data, VkDeviceSize size)
+{
+    (void)add_entry(name, pack::asset_type::buffer, data, size);
+}
+
+void asset_pack_writer::add_texture(const char* name, VkFormat format, VkExtent3D extent, uint32_t mip_levels,
+    const void* data, VkDeviceSize size, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    pack::entry& entry = add_entry(name, pack::asset_type::texture, data, size);
+    entry.format = format;
+    entry.extent = extent;
+    entry.mip_levels = mip_levels;
+    entry.region_count = region_count;
+
+    m_assets.back().regions.assign(regions, regions + region_count);
+}
+
+void asset_pack_writer::write(const char* filepath) const
+{
+    std::vector<pack::entry> entries {};
+    entries.reserve(m_assets.size());
+
+    uint64_t offset = align_up(sizeof(pack::header), pack::data_alignment);
+    for (const auto& asset : m_assets) {
+        auto& entry = entries.emplace_back(asset.entry);
+        entry.data_offset = offset;
+        offset = align_up(offset + entry.data_size, pack::data_alignment);
+    }
+
+    pack::header header {};
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.metadata_offset = offset;
+    for (std::size_t i = 0; i < m_assets.size(); i++) {
+        entries[i].regions_offset = offset;
+        offset += m_assets[i].regions.size() * sizeof(VkBufferImageCopy);
+    }
+    header.entries_offset = align_up(offset, alignof(pack::entry));
+
+    // sorted by name so lookups can binary search the mapped table
+    std::vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&entries](uint32_t a, uint32_t b) {
+        return std::strcmp(entries[a].name, entries[b].name) < 0;
+    });
+    for (std::size_t i = 1; i < order.size(); i++) {
+        quix_assert(std::strcmp(entries[order[i - 1]].name, entries[order[i]].name) != 0,
+            fmt::format("asset {} is added twice", entries[order[i]].name));
+    }
+
+    FILE* handle = fopen(filepath, "wb");
+    quix_assert(handle != nullptr, fmt::format("failed to create pack file {}", filepath));
+
+    write_at(handle, 0, &header, sizeof(header));
+    for (std::size_t i = 0; i < m_assets.size(); i++) {
+        write_at(handle, entries[i].data_offset, m_assets[i].data.data(), m_assets[i].data.size());
+        write_at(handle, entries[i].regions_offset, m_assets[i].regions.data(), m_assets[i].regions.size() * sizeof(VkBufferImageCopy));
+    }
+    for (std::size_t i = 0; i < order.size(); i++) {
+        write_at(handle, header.entries_offset + i * sizeof(pack::entry), &entries[order[i]], sizeof(pack::entry));
+    }
+
+    (void)fclose(handle);
+}
+
+asset_pack::asset_pack(const char* filepath, pack_access access)
+    : m_access(access)
+{
+    m_file = open(filepath, O_RDONLY);
+    quix_assert(m_file != -1, fmt::format("failed to open pack file {}", filepath));
+
+    struct stat file_stat {};
+    quix_assert(fstat(m_file, &file_stat) == 0, fmt::format("failed to stat pack file {}", filepath));
+    m_file_size = static_cast<std::size_t>(file_stat.st_size);
+    quix_assert(m_file_size >= sizeof(pack::header), fmt::format("{} is not a pack file", filepath));
+
+    pack::header header {};
+    if (m_access == pack_access::mapped) {
+        void* mapping = mmap(nullptr, m_file_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        quix_assert(mapping != MAP_FAILED, fmt::format("failed to map pack file {}", filepath));
+        m_mapping = static_cast<const char*>(mapping);
+        std::memcpy(&header, m_mapping, sizeof(header));
+    } else {
+        read_at(m_file, 0, &header, sizeof(header));
+    }
+
+    quix_assert(header.magic == pack::magic && header.version == pack::version, fmt::format("{} is not a version {} pack file", filepath, pack::version));
+    quix_assert(header.metadata_offset <= header.entries_offset && header.entries_offset <= m_file_size
+            && header.entry_count <= (m_file_size - header.entries_offset) / sizeof(pack::entry),
+        fmt::format("pack file {} is truncated", filepath));
+
+    m_metadata_offset = header.metadata_offset;
+    if (m_access == pack_access::read) {
+        m_metadata_copy.resize(m_file_size - m_metadata_offset);
+        read_at(m_file, m_metadata_offset, m_metadata_copy.data(), m_metadata_copy.size());
+    }
+
+    m_entries = reinterpret_cast<const pack::entry*>(get_metadata(header.entries_offset));
+    m_entry_count = header.entry_count;
+
+    // everything below comes from the file, find runs strcmp over the names and the regions go straight into copy commands
+    for (std::size_t i = 0; i < m_entry_count; i++) {
+        const pack::entry& entry = m_entries[i];
+        quix_assert(entry.name[pack::max_name_length] == '\0', "pack file has an unterminated asset name");
+        quix_assert(entry.data_offset <= m_file_size && entry.data_size <= m_file_size - entry.data_offset, "pack asset data points past the end of the file");
+        quix_assert(entry.regions_offset >= header.metadata_offset && entry.regions_offset <= header.entries_offset
+                && entry.region_count <= (header.entries_offset - entry.regions_offset) / sizeof(VkBufferImageCopy),
+            "pack asset regions lie outside the region table");
+
+        const VkBufferImageCopy* regions = get_regions(&entry);
+        for (uint32_t region = 0; region < entry.region_count; region++) {
+            quix_assert(regions[region].bufferOffset < entry.data_size && regions[region].imageSubresource.mipLevel < entry.mip_levels,
+                "pack asset region lies outside the asset");
+        }
+    }
+}
+
+asset_pack::~asset_pack()
+{
+    if (m_mapping != nullptr) {
+        (void)munmap(const_cast<char*>(m_mapping), m_file_size);
+    }
+    if (m_file != -1) {
+        (void)close(m_file);
+    }
+}
+
+NODISCARD const pack::entry* asset_pack::find(const char* name) const noexcept
+{
+    const pack::entry* end = m_entries + m_entry_count;
+    const pack::entry* found = std::lower_bound(m_entries, end, name, [](const pack::entry& entry, const char* value) {
+        return std::strcmp(entry.name, value) < 0;
+    });
+
+    if (found == end || std::strcmp(found->name, name) != 0) {
+        return nullptr;
+    }
+    return found;
+}
+
+NODISCARD const VkBufferImageCopy* asset_pack::get_regions(const pack::entry* entry) const noexcept
+{
+    return reinterpret_cast<const VkBufferImageCopy*>(get_metadata(entry->regions_offset));
+}
+
+void asset_pack::read(const pack::entry* entry, void* dst) const
+{
+    quix_assert(entry->data_offset <= m_file_size && entry->data_size <= m_file_size - entry->data_offset,
+        fmt::format("asset {} points past the end of the pack", entry->name));
+
+    if (m_access == pack_access::mapped) {
+        std::memcpy(dst, m_mapping + entry->data_offset, entry->data_size);
+    } else {
+        read_at(m_file, entry->data_offset, dst, entry->data_size);
+    }
+}
+
+NODISCARD const char* asset_pack::get_metadata(uint64_t offset) const noexcept
+{
+    if (m_mapping != nullptr) {
+        return m_mapping + offset;
+    }
+    return m_metadata_copy.data() + (offset - m_metadata_offset);
+}
+
+} // namespace quix
+
+#endif // _QUIX_ASSET_PACK_CPP
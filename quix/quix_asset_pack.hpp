@@ -0,0 +1,112 @@
+#ifndef _QUIX_ASSET_PACK_HPP
+#define _QUIX_ASSET_PACK_HPP
+
+namespace quix {
+
+// a pack holds assets in the exact form they are uploaded in, textures keep their final format and full mip chain,
+// the file is laid out as header, asset data, texture regions and the name sorted entry table
+namespace pack {
+
+    constexpr uint32_t magic = 0x4b505851; // "QXPK"
+    constexpr uint32_t version = 1;
+    // every asset starts on this alignment, a multiple of any optimalBufferCopyOffsetAlignment and texel block size
+    constexpr uint64_t data_alignment = 256;
+    constexpr std::size_t max_name_length = 63;
+
+    enum class asset_type : uint32_t {
+        buffer,
+        texture,
+    };
+
+    struct header {
+        uint32_t magic = pack::magic;
+        uint32_t version = pack::version;
+        uint32_t entry_count = 0;
+        uint32_t reserved = 0;
+        // start of everything after the asset data, only this tail is read into memory when the pack is not mapped
+        uint64_t metadata_offset = 0;
+        uint64_t entries_offset = 0;
+    };
+
+    // offsets are from the start of the file, region bufferOffsets are relative to data_offset
+    struct entry {
+        char name[max_name_length + 1] {};
+        asset_type type = asset_type::buffer;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent3D extent {};
+        uint32_t mip_levels = 0;
+        uint32_t region_count = 0;
+        uint64_t regions_offset = 0;
+        uint64_t data_offset = 0;
+        uint64_t data_size = 0;
+    };
+
+    static_assert(std::is_trivially_copyable_v<header> && std::is_trivially_copyable_v<entry>, "pack structures are written as they are");
+
+} // namespace pack
+
+// collects assets and writes them as one pack, used by the offline cooker
+class asset_pack_writer {
+public:
+    void add_buffer(const char* name, const void* data, VkDeviceSize size);
+    void add_texture(const char* name, VkFormat format, VkExtent3D extent, uint32_t mip_levels,
+        const void* data, VkDeviceSize size, const VkBufferImageCopy* regions, uint32_t region_count);
+
+    void write(const char* filepath) const;
+
+private:
+    struct pending_asset {
+        pack::entry entry {};
+        std::vector<char> data {};
+        std::vector<VkBufferImageCopy> regions {};
+    };
+
+    pack::entry& add_entry(const char* name, pack::asset_type type, const void* data, VkDeviceSize size);
+
+    std::vector<pending_asset> m_assets {};
+};
+
+enum class pack_access {
+    // the whole file is mapped and assets are copied from the mapping into staging memory
+    mapped,
+    // every asset is read into staging memory with a single pread, nothing but the metadata stays in memory
+    read,
+};
+
+class asset_pack {
+public:
+    explicit asset_pack(const char* filepath, pack_access access = pack_access::mapped);
+    ~asset_pack();
+
+    asset_pack(const asset_pack&) = delete;
+    asset_pack& operator=(const asset_pack&) = delete;
+    asset_pack(asset_pack&&) = delete;
+    asset_pack& operator=(asset_pack&&) = delete;
+
+    // null when the pack holds no asset of that name
+    NODISCARD const pack::entry* find(const char* name) const noexcept;
+    NODISCARD const VkBufferImageCopy* get_regions(const pack::entry* entry) const noexcept;
+    // copies the data of entry to dst, which is usually staging memory reserved on an upload batch
+    void read(const pack::entry* entry, void* dst) const;
+
+    NODISCARD inline uint32_t get_entry_count() const noexcept { return m_entry_count; }
+    NODISCARD inline pack_access get_access() const noexcept { return m_access; }
+
+private:
+    NODISCARD const char* get_metadata(uint64_t offset) const noexcept;
+
+    int m_file = -1;
+    pack_access m_access;
+    std::size_t m_file_size = 0;
+    const char* m_mapping = nullptr;
+
+    // the tail of the file starting at metadata_offset, read into memory when the pack is not mapped
+    std::vector<char> m_metadata_copy {};
+    uint64_t m_metadata_offset = 0;
+    const pack::entry* m_entries = nullptr;
+    uint32_t m_entry_count = 0;
+};
+
+} // namespace quix
+
+#endif // _QUIX_ASSET_PACK_HPP
@@ -4,6 +4,7 @@
 #include "quix_commands.hpp"
 
 #include "quix_device.hpp"
+#include "quix_jobs.hpp"
 #include "quix_pipeline.hpp"
 #include "quix_render_target.hpp"
 #include "quix_resource.hpp"
@@ -11,6 +12,27 @@
 
 namespace quix {
 
+namespace {
+
+    NODISCARD VkRenderingAttachmentInfo to_attachment_info(const rendering_attachment& attachment)
+    {
+        VkRenderingAttachmentInfo info {};
+        info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        info.imageView = attachment.view;
+        info.imageLayout = attachment.layout;
+        info.loadOp = attachment.load_op;
+        info.storeOp = attachment.store_op;
+        info.clearValue = attachment.clear_value;
+        if (attachment.resolve_view != VK_NULL_HANDLE) {
+            info.resolveMode = attachment.resolve_mode;
+            info.resolveImageView = attachment.resolve_view;
+            info.resolveImageLayout = attachment.layout;
+        }
+        return info;
+    }
+
+} // namespace
+
 sync::sync(weakref<device> p_device, weakref<swapchain> p_swapchain)
     : m_device(std::move(p_device))
     , m_swapchain(std::move(p_swapchain))
@@ -24,41 +46,27 @@ sync::~sync()
     destroy_sync_objects();
 }
 
-void sync::wait_for_fence(const int frame)
+void sync::wait_for_frame(const int frame)
 {
-    vkWaitForFences(m_device->get_logical_device(), 1, &m_fences[frame], VK_TRUE, UINT64_MAX);
-}
-
-void sync::reset_fence(const int frame)
-{
-    vkResetFences(m_device->get_logical_device(), 1, &m_fences[frame]);
+    m_device->wait(m_frame_points[frame]);
 }
 
 VkResult sync::acquire_next_image(const int frame, uint32_t* image_index)
 {
-    vkWaitForFences(m_device->get_logical_device(), 1, &m_fences[frame], VK_TRUE, UINT64_MAX);
+    wait_for_frame(frame);
+    m_device->collect_garbage();
     return vkAcquireNextImageKHR(m_device->get_logical_device(), m_swapchain->get_swapchain(), UINT64_MAX, m_available_semaphores[frame], VK_NULL_HANDLE, image_index);
 }
 
-VkResult sync::submit_frame(const int frame, command_list* command)
+timeline_point sync::submit_frame(const int frame, command_list* command)
 {
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = { m_available_semaphores[frame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = command->get_cmd_buffer_ref();
+    submit_dependencies dependencies {};
+    dependencies.binary_wait = m_available_semaphores[frame];
+    dependencies.binary_wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies.binary_signal = m_finished_semaphores[frame];
 
-    VkSemaphore signalSemaphores[] = { m_finished_semaphores[frame] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    return vkQueueSubmit(m_device->get_graphics_queue(), 1, &submitInfo, m_fences[frame]);
+    m_frame_points[frame] = command->submit(&dependencies);
+    return m_frame_points[frame];
 }
 
 VkResult sync::present_frame(const int frame, const uint32_t image_index)
@@ -76,29 +84,21 @@ VkResult sync::present_frame(const int frame, const uint32_t image_index)
     presentInfo.pImageIndices = &image_index;
     presentInfo.pResults = nullptr; // Optional
 
-    return vkQueuePresentKHR(m_device->get_present_queue(), &presentInfo);
+    return m_device->present(&presentInfo);
 }
 
 void sync::create_sync_objects()
 {
-    m_sync_buffer = malloc(sizeof(VkSemaphore) * (m_frames_in_flight * 2) + sizeof(VkFence) * m_frames_in_flight);
-    quix_assert(m_sync_buffer != nullptr, "failed to allocate memory for synchronization objects");
-
-    m_fences = (VkFence*)m_sync_buffer;
-    m_available_semaphores = (VkSemaphore*)((char*)m_sync_buffer + sizeof(VkFence) * m_frames_in_flight);
-    m_finished_semaphores = (VkSemaphore*)((char*)m_sync_buffer + sizeof(VkFence) * m_frames_in_flight + sizeof(VkSemaphore) * m_frames_in_flight);
+    m_frame_points.resize(m_frames_in_flight);
+    m_available_semaphores.resize(m_frames_in_flight);
+    m_finished_semaphores.resize(m_frames_in_flight);
 
     VkSemaphoreCreateInfo semaphoreInfo {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (int i = 0; i < m_frames_in_flight; i++) {
         VK_CHECK(vkCreateSemaphore(m_device->get_logical_device(), &semaphoreInfo, nullptr, &m_available_semaphores[i]), "failed to create semaphore");
         VK_CHECK(vkCreateSemaphore(m_device->get_logical_device(), &semaphoreInfo, nullptr, &m_finished_semaphores[i]), "failed to create semaphore");
-        VK_CHECK(vkCreateFence(m_device->get_logical_device(), &fenceInfo, nullptr, &m_fences[i]), "failed to create fence");
     }
 }
 
@@ -107,26 +107,31 @@ void sync::destroy_sync_objects()
     for (int i = 0; i < m_frames_in_flight; i++) {
         vkDestroySemaphore(m_device->get_logical_device(), m_available_semaphores[i], nullptr);
         vkDestroySemaphore(m_device->get_logical_device(), m_finished_semaphores[i], nullptr);
-        vkDestroyFence(m_device->get_logical_device(), m_fences[i], nullptr);
     }
-    free(m_sync_buffer);
 }
 
-command_list::command_list(weakref<device> p_device, VkCommandBuffer buffer)
+command_list::command_list(weakref<device> p_device, VkCommandBuffer buffer, queue_type type, command_pool* owner, VkCommandBufferLevel level)
     : m_device(std::move(p_device))
     , buffer(buffer)
+    , m_queue_type(type)
+    , m_owner(owner)
+    , m_level(level)
 {
 }
 
-void command_list::begin_record(VkCommandBufferUsageFlags flags)
+void command_list::begin_record(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo* inheritance_info)
 {
+    m_executed_lists.clear();
+    m_state = {};
+    m_stats = {};
+
     VkCommandBufferBeginInfo begin_info {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     /*VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT: The command buffer will be rerecorded right after executing it once.
       VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT: This is a secondary command buffer that will be entirely within a single render pass.
       VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT: The command buffer can be resubmitted while it is also already pending execution. */
     begin_info.flags = flags;
-    begin_info.pInheritanceInfo = nullptr; // for secondary command buffers
+    begin_info.pInheritanceInfo = inheritance_info; // for secondary command buffers
 
     VK_CHECK(vkBeginCommandBuffer(buffer, &begin_info), "failed to begin command buffer record");
 }
@@ -136,7 +141,7 @@ void command_list::end_record()
     VK_CHECK(vkEndCommandBuffer(buffer), "failed to record command buffer!");
 }
 
-void command_list::begin_render_pass(const render_target& r_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index, VkClearValue* clear_value, uint32_t clear_value_count)
+void command_list::begin_render_pass(const render_target& r_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index, VkClearValue* clear_value, uint32_t clear_value_count, VkSubpassContents contents)
 {
     VkRenderPassBeginInfo render_pass_begin_info {};
     render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -150,25 +155,253 @@ void command_list::begin_render_pass(const render_target& r_target, const std::s
     render_pass_begin_info.clearValueCount = clear_value_count;
     render_pass_begin_info.pClearValues = clear_value;
 
-    vkCmdBeginRenderPass(buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(buffer, &render_pass_begin_info, contents);
+
+    if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+        return;
+    }
+
+    bind_pipeline(p_pipeline);
+    set_viewport_and_scissor(r_target.get_extent());
+}
+
+void command_list::bind_pipeline(const std::shared_ptr<graphics::pipeline>& p_pipeline)
+{
+    const VkPipeline vk_pipeline = p_pipeline->get_pipeline();
+    if (vk_pipeline == m_state.pipeline) {
+        m_stats.filtered_pipelines++;
+        return;
+    }
+
+    vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
+    m_stats.state_commands++;
+    m_state.pipeline = vk_pipeline;
+
+    // sets and push constants survive a pipeline change as long as the layout stays the same
+    if (p_pipeline->get_layout() != m_state.layout) {
+        m_state.layout = p_pipeline->get_layout();
+        m_state.descriptor_sets = {};
+        m_state.push_stages = 0;
+        m_state.push_begin = 0;
+        m_state.push_end = 0;
+    }
+}
+
+void command_list::bind_descriptor_sets(uint32_t first_set, const VkDescriptorSet* sets, uint32_t set_count, const uint32_t* dynamic_offsets, uint32_t dynamic_offset_count)
+{
+    quix_assert(m_state.layout != VK_NULL_HANDLE, "bind a pipeline before binding descriptor sets");
+
+    const auto is_bound = [&](uint32_t slot, VkDescriptorSet set, uint32_t offset_count, const uint32_t* offsets) {
+        if (slot >= max_tracked_sets || m_state.descriptor_sets[slot] != set || m_state.dynamic_offset_counts[slot] != offset_count) {
+            return false;
+        }
+        return offset_count == 0 || m_state.dynamic_offsets[slot] == offsets[0];
+    };
+
+    if (dynamic_offset_count == 0) {
+        // only the sets that differ from what is bound are recorded, trimmed from both ends
+        uint32_t begin = 0;
+        uint32_t end = set_count;
+        while (begin < end && is_bound(first_set + begin, sets[begin], 0, nullptr)) {
+            begin++;
+        }
+        while (end > begin && is_bound(first_set + end - 1, sets[end - 1], 0, nullptr)) {
+            end--;
+        }
+
+        m_stats.filtered_descriptor_sets += set_count - (end - begin);
+        if (begin == end) {
+            return;
+        }
+
+        vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_state.layout, first_set + begin, end - begin, sets + begin, 0, nullptr);
+        m_stats.state_commands++;
+        for (uint32_t i = begin; i < end && first_set + i < max_tracked_sets; i++) {
+            m_state.descriptor_sets[first_set + i] = sets[i];
+            m_state.dynamic_offset_counts[first_set + i] = 0;
+        }
+        return;
+    }
 
-    vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, p_pipeline->get_pipeline());
+    if (set_count == 1 && dynamic_offset_count == 1 && is_bound(first_set, sets[0], 1, dynamic_offsets)) {
+        m_stats.filtered_descriptor_sets++;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_state.layout, first_set, set_count, sets, dynamic_offset_count, dynamic_offsets);
+    m_stats.state_commands++;
+    for (uint32_t i = 0; i < set_count && first_set + i < max_tracked_sets; i++) {
+        m_state.descriptor_sets[first_set + i] = sets[i];
+        m_state.dynamic_offset_counts[first_set + i] = set_count == 1 && dynamic_offset_count == 1 ? 1 : unknown_dynamic_offsets;
+        m_state.dynamic_offsets[first_set + i] = dynamic_offsets[0];
+    }
+}
 
+void command_list::bind_vertex_buffers(uint32_t first_binding, const VkBuffer* buffers, const VkDeviceSize* offsets, uint32_t buffer_count)
+{
+    const auto is_bound = [&](uint32_t index) {
+        const uint32_t binding = first_binding + index;
+        return binding < max_tracked_vertex_buffers && m_state.vertex_buffers[binding] == buffers[index] && m_state.vertex_offsets[binding] == offsets[index];
+    };
+
+    uint32_t begin = 0;
+    uint32_t end = buffer_count;
+    while (begin < end && is_bound(begin)) {
+        begin++;
+    }
+    while (end > begin && is_bound(end - 1)) {
+        end--;
+    }
+
+    m_stats.filtered_vertex_buffers += buffer_count - (end - begin);
+    if (begin == end) {
+        return;
+    }
+
+    vkCmdBindVertexBuffers(buffer, first_binding + begin, end - begin, buffers + begin, offsets + begin);
+    m_stats.state_commands++;
+    for (uint32_t i = begin; i < end && first_binding + i < max_tracked_vertex_buffers; i++) {
+        m_state.vertex_buffers[first_binding + i] = buffers[i];
+        m_state.vertex_offsets[first_binding + i] = offsets[i];
+    }
+}
+
+void command_list::bind_vertex_buffer(VkBuffer vertex_buffer, VkDeviceSize offset)
+{
+    bind_vertex_buffers(0, &vertex_buffer, &offset, 1);
+}
+
+void command_list::bind_index_buffer(VkBuffer index_buffer, VkDeviceSize offset, VkIndexType index_type)
+{
+    if (index_buffer == m_state.index_buffer && offset == m_state.index_offset && index_type == m_state.index_type) {
+        m_stats.filtered_index_buffers++;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(buffer, index_buffer, offset, index_type);
+    m_stats.state_commands++;
+    m_state.index_buffer = index_buffer;
+    m_state.index_offset = offset;
+    m_state.index_type = index_type;
+}
+
+void command_list::set_viewport(const VkViewport& viewport)
+{
+    if (m_state.viewport_valid && std::memcmp(&viewport, &m_state.viewport, sizeof(VkViewport)) == 0) {
+        m_stats.filtered_viewports++;
+        return;
+    }
+
+    vkCmdSetViewport(buffer, 0, 1, &viewport);
+    m_stats.state_commands++;
+    m_state.viewport = viewport;
+    m_state.viewport_valid = true;
+}
+
+void command_list::set_scissor(const VkRect2D& scissor)
+{
+    if (m_state.scissor_valid && std::memcmp(&scissor, &m_state.scissor, sizeof(VkRect2D)) == 0) {
+        m_stats.filtered_scissors++;
+        return;
+    }
+
+    vkCmdSetScissor(buffer, 0, 1, &scissor);
+    m_stats.state_commands++;
+    m_state.scissor = scissor;
+    m_state.scissor_valid = true;
+}
+
+void command_list::set_viewport_and_scissor(VkExtent2D extent)
+{
     VkViewport viewport {};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = static_cast<float>(r_target.get_extent().width);
-    viewport.height = static_cast<float>(r_target.get_extent().height);
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0;
 
-    vkCmdSetViewport(buffer, 0, 1, &viewport);
+    set_viewport(viewport);
 
     VkRect2D scissor {};
     scissor.offset = { 0, 0 };
-    scissor.extent = r_target.get_extent();
+    scissor.extent = extent;
 
-    vkCmdSetScissor(buffer, 0, 1, &scissor);
+    set_scissor(scissor);
+}
+
+void command_list::push_constants(VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+    quix_assert(m_state.layout != VK_NULL_HANDLE, "bind a pipeline before pushing constants");
+
+    const uint32_t end = offset + size;
+    const bool tracked = end <= max_tracked_push_constants;
+    if (tracked && stages == m_state.push_stages && offset >= m_state.push_begin && end <= m_state.push_end
+        && std::memcmp(m_state.push_constants.data() + offset, data, size) == 0) {
+        m_stats.filtered_push_constants++;
+        return;
+    }
+
+    vkCmdPushConstants(buffer, m_state.layout, stages, offset, size, data);
+    m_stats.state_commands++;
+    if (!tracked) {
+        return;
+    }
+
+    // the known range only grows while pushes for the same stages touch or overlap it
+    if (stages != m_state.push_stages || end < m_state.push_begin || offset > m_state.push_end) {
+        m_state.push_stages = stages;
+        m_state.push_begin = offset;
+        m_state.push_end = end;
+    } else {
+        m_state.push_begin = std::min(m_state.push_begin, offset);
+        m_state.push_end = std::max(m_state.push_end, end);
+    }
+    std::memcpy(m_state.push_constants.data() + offset, data, size);
+}
+
+void command_list::invalidate_state() noexcept
+{
+    m_state = {};
+}
+
+void command_list::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+    vkCmdDraw(buffer, vertex_count, instance_count, first_vertex, first_instance);
+    m_stats.draws++;
+}
+
+void command_list::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+    vkCmdDrawIndexed(buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
+    m_stats.draws++;
+}
+
+void command_list::draw_indexed_indirect(VkBuffer command_buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+    vkCmdDrawIndexedIndirect(buffer, command_buffer, offset, draw_count, stride);
+    m_stats.draws++;
+}
+
+void command_list::draw_indexed_indirect_count(VkBuffer command_buffer, VkDeviceSize offset, VkBuffer count_buffer, VkDeviceSize count_offset,
+    uint32_t max_draw_count, uint32_t stride)
+{
+    vkCmdDrawIndexedIndirectCount(buffer, command_buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+    m_stats.draws++;
+}
+
+void command_list::execute_commands(command_list* const* lists, uint32_t list_count)
+{
+    m_execute_buffers.clear();
+    for (uint32_t i = 0; i < list_count; i++) {
+        quix_assert(lists[i]->get_level() == VK_COMMAND_BUFFER_LEVEL_SECONDARY, "only secondary command lists can be executed");
+        m_execute_buffers.push_back(lists[i]->get_cmd_buffer());
+        m_executed_lists.push_back(lists[i]);
+    }
+
+    vkCmdExecuteCommands(buffer, list_count, m_execute_buffers.data());
+    // the state of the primary is undefined after executing secondary lists
+    invalidate_state();
 }
 
 void command_list::end_render_pass()
@@ -176,6 +409,116 @@ void command_list::end_render_pass()
     vkCmdEndRenderPass(buffer);
 }
 
+void command_list::begin_rendering(VkExtent2D extent, const rendering_attachment* color_attachments, uint32_t color_attachment_count,
+    const rendering_attachment* depth_attachment, const rendering_attachment* stencil_attachment, VkRenderingFlags flags)
+{
+    quix_assert(color_attachment_count <= rendering_formats::max_color_attachments, "too many color attachments");
+
+    std::array<VkRenderingAttachmentInfo, rendering_formats::max_color_attachments> color_infos {};
+    for (uint32_t i = 0; i < color_attachment_count; i++) {
+        color_infos[i] = to_attachment_info(color_attachments[i]);
+    }
+    const VkRenderingAttachmentInfo depth_info = depth_attachment != nullptr ? to_attachment_info(*depth_attachment) : VkRenderingAttachmentInfo {};
+    const VkRenderingAttachmentInfo stencil_info = stencil_attachment != nullptr ? to_attachment_info(*stencil_attachment) : VkRenderingAttachmentInfo {};
+
+    VkRenderingInfo rendering_info {};
+    rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    rendering_info.flags = flags;
+    rendering_info.renderArea = { { 0, 0 }, extent };
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = color_attachment_count;
+    rendering_info.pColorAttachments = color_infos.data();
+    rendering_info.pDepthAttachment = depth_attachment != nullptr ? &depth_info : nullptr;
+    rendering_info.pStencilAttachment = stencil_attachment != nullptr ? &stencil_info : nullptr;
+
+    vkCmdBeginRendering(buffer, &rendering_info);
+}
+
+void command_list::begin_rendering(const render_target& r_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index,
+    const VkClearValue* clear_values, uint32_t clear_value_count, VkRenderingFlags flags)
+{
+    quix_assert(r_target.is_dynamic() && !r_target.is_offscreen(), "begin_rendering needs a dynamic swapchain render target");
+
+    const rendering_formats formats = r_target.get_rendering_formats();
+    const VkImageView depth_view = r_target.get_depth_view();
+
+    // the swapchain image is acquired with a wait at the color output stage, the depth image was last written by the
+    // previous frame, neither keeps its contents
+    std::array<VkImageMemoryBarrier, 2> barriers {};
+    barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask = 0;
+    barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image = r_target.get_color_image(image_index);
+    barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].image = r_target.get_depth_image();
+    barriers[1].subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+    if (formats.stencil_format != VK_FORMAT_UNDEFINED) {
+        barriers[1].subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    const uint32_t barrier_count = depth_view != VK_NULL_HANDLE ? 2 : 1;
+    pipeline_barrier(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        nullptr, 0, barriers.data(), barrier_count);
+
+    rendering_attachment color {};
+    color.view = r_target.get_color_view(image_index);
+    color.clear_value = clear_value_count > 0 ? clear_values[0] : VkClearValue {};
+
+    rendering_attachment depth {};
+    depth.view = depth_view;
+    depth.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth.store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth.clear_value = clear_value_count > 1 ? clear_values[1] : VkClearValue {};
+
+    const bool has_depth = depth_view != VK_NULL_HANDLE;
+    begin_rendering(r_target.get_extent(), &color, 1, has_depth ? &depth : nullptr,
+        has_depth && formats.stencil_format != VK_FORMAT_UNDEFINED ? &depth : nullptr, flags);
+    m_present_image = barriers[0].image;
+
+    if ((flags & VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT) != 0) {
+        return;
+    }
+
+    bind_pipeline(p_pipeline);
+    set_viewport_and_scissor(r_target.get_extent());
+}
+
+void command_list::end_rendering()
+{
+    vkCmdEndRendering(buffer);
+
+    if (m_present_image == VK_NULL_HANDLE) {
+        return;
+    }
+
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = m_present_image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    pipeline_barrier(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, nullptr, 0, &barrier, 1);
+
+    m_present_image = VK_NULL_HANDLE;
+}
+
 void command_list::copy_buffer_to_buffer(VkBuffer src_buffer, VkDeviceSize src_offset, VkBuffer dst_buffer, VkDeviceSize dst_offset, VkDeviceSize size)
 {
     VkBufferCopy copy_region {};
@@ -186,6 +529,16 @@ void command_list::copy_buffer_to_buffer(VkBuffer src_buffer, VkDeviceSize src_o
     vkCmdCopyBuffer(buffer, src_buffer, dst_buffer, 1, &copy_region);
 }
 
+void command_list::copy_buffer_to_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, const VkBufferCopy* regions, uint32_t region_count)
+{
+    vkCmdCopyBuffer(buffer, src_buffer, dst_buffer, region_count, regions);
+}
+
+void command_list::fill_buffer(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+{
+    vkCmdFillBuffer(buffer, dst_buffer, offset, size, value);
+}
+
 void command_list::copy_buffer_to_image(VkBuffer src_buffer, VkDeviceSize buffer_offset, image_handle* dst_image, VkOffset3D image_offset, VkImageAspectFlags aspect_mask)
 {
     VkBufferImageCopy copy_region {};
@@ -199,7 +552,7 @@ void command_list::copy_buffer_to_image(VkBuffer src_buffer, VkDeviceSize buffer
     copy_region.imageSubresource.aspectMask = aspect_mask;
     copy_region.imageSubresource.baseArrayLayer = 0;
     copy_region.imageSubresource.layerCount = dst_image->m_array_layers;
-    copy_region.imageSubresource.mipLevel = dst_image->m_mip_levels-1;
+    copy_region.imageSubresource.mipLevel = 0;
 
     vkCmdCopyBufferToImage(
         buffer, src_buffer,
@@ -207,19 +560,32 @@ void command_list::copy_buffer_to_image(VkBuffer src_buffer, VkDeviceSize buffer
         1, &copy_region);
 }
 
+void command_list::copy_buffer_to_image(VkBuffer src_buffer, image_handle* dst_image, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    copy_buffer_to_image(src_buffer, dst_image->get_image(), regions, region_count);
+}
+
+void command_list::copy_buffer_to_image(VkBuffer src_buffer, VkImage dst_image, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    vkCmdCopyBufferToImage(
+        buffer, src_buffer,
+        dst_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        region_count, regions);
+}
+
 void command_list::copy_image_to_image(image_handle* src, VkOffset3D src_offset, image_handle* dst, VkOffset3D dst_offset, VkImageAspectFlags aspect_mask)
 {
     VkImageCopy copy_region {};
     copy_region.srcOffset = src_offset;
     copy_region.srcSubresource.layerCount = src->m_array_layers;
     copy_region.srcSubresource.baseArrayLayer = 0;
-    copy_region.srcSubresource.mipLevel = src->m_mip_levels;
+    copy_region.srcSubresource.mipLevel = 0;
     copy_region.srcSubresource.aspectMask = aspect_mask;
 
     copy_region.dstOffset = dst_offset;
     copy_region.dstSubresource.layerCount = dst->m_array_layers;
     copy_region.dstSubresource.baseArrayLayer = 0;
-    copy_region.dstSubresource.mipLevel = dst->m_mip_levels;
+    copy_region.dstSubresource.mipLevel = 0;
     copy_region.dstSubresource.aspectMask = aspect_mask;
     copy_region.extent = src->m_extent;
 
@@ -229,14 +595,110 @@ void command_list::copy_image_to_image(image_handle* src, VkOffset3D src_offset,
 }
 
 void command_list::image_barrier(image_handle* image, image_barrier_info* barrier_info, VkImageAspectFlags aspect_mask)
+{
+    record_image_barrier(image, barrier_info, aspect_mask, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+}
+
+void command_list::pipeline_barrier(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+    const VkBufferMemoryBarrier* buffer_barriers, uint32_t buffer_barrier_count,
+    const VkImageMemoryBarrier* image_barriers, uint32_t image_barrier_count)
+{
+    if (buffer_barrier_count == 0 && image_barrier_count == 0) {
+        return;
+    }
+
+    vkCmdPipelineBarrier(
+        buffer,
+        src_stage, dst_stage,
+        0,
+        0, nullptr,
+        buffer_barrier_count, buffer_barriers,
+        image_barrier_count, image_barriers);
+}
+
+void command_list::pipeline_barrier(const VkDependencyInfo* dependency_info)
+{
+    if (dependency_info->memoryBarrierCount == 0 && dependency_info->bufferMemoryBarrierCount == 0 && dependency_info->imageMemoryBarrierCount == 0) {
+        return;
+    }
+
+    quix_assert(m_device->get_enabled_features().vulkan13.synchronization2 == VK_TRUE, "synchronization2 barriers need the synchronization2 feature");
+    vkCmdPipelineBarrier2(buffer, dependency_info);
+}
+
+void command_list::release_image_ownership(image_handle* image, const image_barrier_info* barrier_info, queue_type dst_queue, VkImageAspectFlags aspect_mask)
+{
+    const uint32_t src_family = m_device->get_queue_family(m_queue_type);
+    const uint32_t dst_family = m_device->get_queue_family(dst_queue);
+    if (src_family == dst_family) {
+        return;
+    }
+
+    // the destination half of a release is ignored by the driver
+    image_barrier_info release_info = *barrier_info;
+    release_info.dst_access_mask = 0;
+    release_info.dst_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    record_image_barrier(image, &release_info, aspect_mask, src_family, dst_family);
+}
+
+void command_list::acquire_image_ownership(image_handle* image, const image_barrier_info* barrier_info, queue_type src_queue, VkImageAspectFlags aspect_mask)
+{
+    const uint32_t src_family = m_device->get_queue_family(src_queue);
+    const uint32_t dst_family = m_device->get_queue_family(m_queue_type);
+    if (src_family == dst_family) {
+        record_image_barrier(image, barrier_info, aspect_mask, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        return;
+    }
+
+    // the source half of an acquire is ignored by the driver, the semaphore wait provides the dependency
+    image_barrier_info acquire_info = *barrier_info;
+    acquire_info.src_access_mask = 0;
+    acquire_info.src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    record_image_barrier(image, &acquire_info, aspect_mask, src_family, dst_family);
+}
+
+void command_list::release_buffer_ownership(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, queue_type dst_queue)
+{
+    const uint32_t src_family = m_device->get_queue_family(m_queue_type);
+    const uint32_t dst_family = m_device->get_queue_family(dst_queue);
+    if (src_family == dst_family) {
+        return;
+    }
+
+    buffer_barrier_info release_info = *barrier_info;
+    release_info.dst_access_mask = 0;
+    release_info.dst_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    record_buffer_barrier(dst_buffer, offset, size, &release_info, src_family, dst_family);
+}
+
+void command_list::acquire_buffer_ownership(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, queue_type src_queue)
+{
+    const uint32_t src_family = m_device->get_queue_family(src_queue);
+    const uint32_t dst_family = m_device->get_queue_family(m_queue_type);
+    if (src_family == dst_family) {
+        record_buffer_barrier(dst_buffer, offset, size, barrier_info, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        return;
+    }
+
+    buffer_barrier_info acquire_info = *barrier_info;
+    acquire_info.src_access_mask = 0;
+    acquire_info.src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    record_buffer_barrier(dst_buffer, offset, size, &acquire_info, src_family, dst_family);
+}
+
+void command_list::record_image_barrier(image_handle* image, const image_barrier_info* barrier_info, VkImageAspectFlags aspect_mask, uint32_t src_family, uint32_t dst_family)
 {
     VkImageMemoryBarrier memory_barrier_info {};
     memory_barrier_info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     memory_barrier_info.image = image->get_image();
     memory_barrier_info.oldLayout = barrier_info->old_layout;
     memory_barrier_info.newLayout = barrier_info->new_layout;
-    memory_barrier_info.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    memory_barrier_info.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    memory_barrier_info.srcQueueFamilyIndex = src_family;
+    memory_barrier_info.dstQueueFamilyIndex = dst_family;
 
     memory_barrier_info.subresourceRange.aspectMask = aspect_mask;
     memory_barrier_info.subresourceRange.baseMipLevel = 0;
@@ -256,39 +718,334 @@ void command_list::image_barrier(image_handle* image, image_barrier_info* barrie
         1, &memory_barrier_info);
 }
 
-void command_list::submit(VkFence fence)
+void command_list::record_buffer_barrier(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, uint32_t src_family, uint32_t dst_family)
 {
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &buffer;
+    VkBufferMemoryBarrier memory_barrier_info {};
+    memory_barrier_info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    memory_barrier_info.buffer = dst_buffer;
+    memory_barrier_info.offset = offset;
+    memory_barrier_info.size = size;
+    memory_barrier_info.srcQueueFamilyIndex = src_family;
+    memory_barrier_info.dstQueueFamilyIndex = dst_family;
+    memory_barrier_info.srcAccessMask = barrier_info->src_access_mask;
+    memory_barrier_info.dstAccessMask = barrier_info->dst_access_mask;
+
+    vkCmdPipelineBarrier(
+        buffer,
+        barrier_info->src_stage, barrier_info->dst_stage,
+        0,
+        0, nullptr,
+        1, &memory_barrier_info,
+        0, nullptr);
+}
 
-    VK_CHECK(vkQueueSubmit(m_device->get_graphics_queue(), 1, &submitInfo, fence), "failed to submit command buffer");
+timeline_point command_list::submit(const submit_dependencies* dependencies)
+{
+    track_submit(m_device->submit(m_queue_type, &buffer, 1, dependencies));
+    return m_last_submit;
 }
 
-command_pool::command_pool(weakref<device> p_device, VkCommandPool pool)
+void command_list::track_submit(timeline_point point)
+{
+    m_last_submit = point;
+    if (m_owner != nullptr) {
+        m_owner->track_submit(point);
+    }
+
+    // executed secondary lists are in flight for as long as this list is
+    for (auto* executed : m_executed_lists) {
+        executed->track_submit(point);
+    }
+}
+
+command_pool::command_pool(weakref<device> p_device, VkCommandPool pool, queue_type type, command_pool_usage usage, command_buffer_lists&& buffers)
     : m_device(std::move(p_device))
     , pool(pool)
+    , m_queue_type(type)
+    , m_usage(usage)
+    , m_free_buffers(std::move(buffers))
 {
 }
 
 command_pool::~command_pool()
 {
-    m_device->return_command_pool(pool);
+    quix_assert(m_live_lists == 0, "command lists must be dropped before their pool");
+
+    // the device resets the pool before handing it out again, which makes every buffer reusable
+    for (const auto& pending : m_pending_buffers) {
+        m_free_buffers[pending.level].push_back(pending.buffer);
+    }
+
+    m_device->retire_command_pool(pool, m_queue_type, m_usage, m_last_submit, std::move(m_free_buffers));
 }
 
 NODISCARD allocated_unique_ptr<command_list> command_pool::create_command_list(VkCommandBufferLevel level)
 {
-    VkCommandBufferAllocateInfo alloc_info {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    alloc_info.commandPool = pool;
-    alloc_info.level = level;
-    alloc_info.commandBufferCount = 1;
+    VkCommandBuffer buffer = acquire_buffer(level);
+    m_live_lists++;
+
+    void* allocation = m_allocator.allocate(sizeof(command_list), alignof(command_list));
+    auto* list = new (allocation) command_list { m_device, buffer, m_queue_type, this, level };
+
+    return allocated_unique_ptr<command_list> {
+        list, [this](command_list* ptr) {
+            release_buffer(ptr->get_cmd_buffer(), ptr->get_level(), ptr->get_last_submit());
+            ptr->~command_list();
+            m_allocator.deallocate(ptr, sizeof(command_list), alignof(command_list));
+        }
+    };
+}
+
+void command_pool::reset()
+{
+    quix_assert(m_live_lists == 0, "command lists must be dropped before resetting their pool");
+    quix_assert(m_device->is_complete(m_last_submit), "command pool reset while its submissions are still executing");
+
+    VK_CHECK(vkResetCommandPool(m_device->get_logical_device(), pool, 0), "failed to reset command pool");
+
+    for (const auto& pending : m_pending_buffers) {
+        m_free_buffers[pending.level].push_back(pending.buffer);
+    }
+    m_pending_buffers.clear();
+}
+
+NODISCARD VkCommandBuffer command_pool::acquire_buffer(VkCommandBufferLevel level)
+{
+    if (m_usage == command_pool_usage::persistent) {
+        recycle_completed_buffers();
+    }
+
+    auto& free_buffers = m_free_buffers[level];
+    if (free_buffers.empty()) {
+        VkCommandBufferAllocateInfo alloc_info {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = pool;
+        alloc_info.level = level;
+        alloc_info.commandBufferCount = buffer_block_size;
+
+        free_buffers.resize(buffer_block_size);
+        VK_CHECK(vkAllocateCommandBuffers(m_device->get_logical_device(), &alloc_info, free_buffers.data()), "failed to allocate command buffers");
+    }
+
+    VkCommandBuffer buffer = free_buffers.back();
+    free_buffers.pop_back();
+
+    return buffer;
+}
+
+void command_pool::release_buffer(VkCommandBuffer buffer, VkCommandBufferLevel level, timeline_point last_submit)
+{
+    m_live_lists--;
+    m_pending_buffers.push_back(pending_buffer { buffer, level, last_submit });
+}
+
+void command_pool::recycle_completed_buffers()
+{
+    // only persistent pools can reset a single buffer
+    while (!m_pending_buffers.empty() && m_device->is_complete(m_pending_buffers.front().last_submit)) {
+        const auto& pending = m_pending_buffers.front();
+        VK_CHECK(vkResetCommandBuffer(pending.buffer, 0), "failed to reset command buffer");
+        m_free_buffers[pending.level].push_back(pending.buffer);
+        m_pending_buffers.pop_front();
+    }
+}
+
+barrier_batch& barrier_batch::memory(barrier_scope src, barrier_scope dst)
+{
+    if (m_memory_barriers.empty()) {
+        VkMemoryBarrier2 barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        m_memory_barriers.push_back(barrier);
+    }
+
+    VkMemoryBarrier2& barrier = m_memory_barriers.front();
+    barrier.srcStageMask |= src.stage;
+    barrier.srcAccessMask |= src.access;
+    barrier.dstStageMask |= dst.stage;
+    barrier.dstAccessMask |= dst.access;
+    return *this;
+}
+
+barrier_batch& barrier_batch::buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, barrier_scope src, barrier_scope dst)
+{
+    for (auto& barrier : m_buffer_barriers) {
+        if (barrier.buffer == buffer && barrier.offset == offset && barrier.size == size) {
+            barrier.srcStageMask |= src.stage;
+            barrier.srcAccessMask |= src.access;
+            barrier.dstStageMask |= dst.stage;
+            barrier.dstAccessMask |= dst.access;
+            return *this;
+        }
+    }
+
+    VkBufferMemoryBarrier2 barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcStageMask = src.stage;
+    barrier.srcAccessMask = src.access;
+    barrier.dstStageMask = dst.stage;
+    barrier.dstAccessMask = dst.access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    m_buffer_barriers.push_back(barrier);
+    return *this;
+}
+
+barrier_batch& barrier_batch::image(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, barrier_scope src, barrier_scope dst,
+    const VkImageSubresourceRange& range)
+{
+    for (auto& barrier : m_image_barriers) {
+        const VkImageSubresourceRange& other = barrier.subresourceRange;
+        if (barrier.image != image || other.aspectMask != range.aspectMask || other.baseMipLevel != range.baseMipLevel || other.levelCount != range.levelCount
+            || other.baseArrayLayer != range.baseArrayLayer || other.layerCount != range.layerCount) {
+            continue;
+        }
+
+        // barriers within one call are unordered, a second transition of the same subresources would race the first
+        quix_assert(barrier.oldLayout == old_layout && barrier.newLayout == new_layout, "an image is transitioned twice in one barrier batch");
+        barrier.srcStageMask |= src.stage;
+        barrier.srcAccessMask |= src.access;
+        barrier.dstStageMask |= dst.stage;
+        barrier.dstAccessMask |= dst.access;
+        return *this;
+    }
+
+    VkImageMemoryBarrier2 barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = src.stage;
+    barrier.srcAccessMask = src.access;
+    barrier.dstStageMask = dst.stage;
+    barrier.dstAccessMask = dst.access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    m_image_barriers.push_back(barrier);
+    return *this;
+}
+
+barrier_batch& barrier_batch::image(const image_handle* image, VkImageLayout old_layout, VkImageLayout new_layout, barrier_scope src, barrier_scope dst,
+    VkImageAspectFlags aspect_mask)
+{
+    const VkImageSubresourceRange range { aspect_mask, 0, image->get_mip_levels(), 0, image->get_array_layers() };
+    return this->image(image->get_image(), old_layout, new_layout, src, dst, range);
+}
+
+void barrier_batch::flush(command_list* list)
+{
+    if (empty()) {
+        return;
+    }
+
+    VkDependencyInfo dependency_info {};
+    dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependency_info.memoryBarrierCount = static_cast<uint32_t>(m_memory_barriers.size());
+    dependency_info.pMemoryBarriers = m_memory_barriers.data();
+    dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(m_buffer_barriers.size());
+    dependency_info.pBufferMemoryBarriers = m_buffer_barriers.data();
+    dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(m_image_barriers.size());
+    dependency_info.pImageMemoryBarriers = m_image_barriers.data();
+    list->pipeline_barrier(&dependency_info);
+
+    m_memory_barriers.clear();
+    m_buffer_barriers.clear();
+    m_image_barriers.clear();
+}
+
+secondary_pass::secondary_pass(weakref<device> p_device, weakref<job_system> p_job_system, uint32_t list_count, queue_type type)
+    : m_device(std::move(p_device))
+    , m_job_system(std::move(p_job_system))
+{
+    m_pools.reserve(list_count);
+    m_lists.reserve(list_count);
+    m_list_pointers.reserve(list_count);
+
+    // pools are acquired here so they land in this thread's cache again once the pass is dropped
+    for (uint32_t i = 0; i < list_count; i++) {
+        command_buffer_lists buffers {};
+        VkCommandPool pool = m_device->acquire_command_pool(type, command_pool_usage::persistent, &buffers);
+
+        m_pools.push_back(std::make_unique<command_pool>(m_device, pool, type, command_pool_usage::persistent, std::move(buffers)));
+        m_lists.push_back(m_pools.back()->create_command_list(VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+        m_list_pointers.push_back(m_lists.back().get());
+    }
+
+    m_inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+}
 
-    VkCommandBuffer buffer = VK_NULL_HANDLE;
-    vkAllocateCommandBuffers(m_device->get_logical_device(), &alloc_info, &buffer);
+void secondary_pass::set_target(const render_target& target, uint32_t image_index, uint32_t subpass)
+{
+    if (target.is_dynamic()) {
+        set_target(target.get_rendering_formats(), target.get_extent());
+        return;
+    }
+
+    m_inheritance_info.pNext = nullptr;
+    m_inheritance_info.renderPass = target.get_render_pass();
+    m_inheritance_info.subpass = subpass;
+    m_inheritance_info.framebuffer = target.get_framebuffer(image_index);
+    m_extent = target.get_extent();
+}
+
+void secondary_pass::set_target(const rendering_formats& formats, VkExtent2D extent)
+{
+    m_formats = formats;
+    m_rendering_inheritance = VkCommandBufferInheritanceRenderingInfo {};
+    m_rendering_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    m_rendering_inheritance.colorAttachmentCount = m_formats.color_format_count;
+    m_rendering_inheritance.pColorAttachmentFormats = m_formats.color_formats.data();
+    m_rendering_inheritance.depthAttachmentFormat = m_formats.depth_format;
+    m_rendering_inheritance.stencilAttachmentFormat = m_formats.stencil_format;
+    m_rendering_inheritance.rasterizationSamples = m_formats.samples;
 
-    return allocate_unique<command_list>(&m_allocator, m_device, buffer);
+    m_inheritance_info.pNext = &m_rendering_inheritance;
+    m_inheritance_info.renderPass = VK_NULL_HANDLE;
+    m_inheritance_info.subpass = 0;
+    m_inheritance_info.framebuffer = VK_NULL_HANDLE;
+    m_extent = extent;
+}
+
+command_list* secondary_pass::begin_list(uint32_t index, const std::shared_ptr<graphics::pipeline>& p_pipeline)
+{
+    quix_assert(m_inheritance_info.renderPass != VK_NULL_HANDLE || m_inheritance_info.pNext != nullptr, "secondary pass has no target");
+
+    command_list* list = m_lists[index].get();
+    list->begin_record(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, &m_inheritance_info);
+
+    // nothing is inherited from the primary except the render pass state
+    if (p_pipeline != nullptr) {
+        list->bind_pipeline(p_pipeline);
+    }
+    list->set_viewport_and_scissor(m_extent);
+
+    return list;
+}
+
+void secondary_pass::end_list(uint32_t index)
+{
+    m_lists[index]->end_record();
+}
+
+void secondary_pass::record_parallel(const std::shared_ptr<graphics::pipeline>& p_pipeline, const std::function<void(command_list*, uint32_t)>& record)
+{
+    // named so it outlives the jobs, parallel_for only keeps a reference
+    const std::function<void(uint32_t)> record_list = [&](uint32_t index) {
+        record(begin_list(index, p_pipeline), index);
+        end_list(index);
+    };
+
+    job_counter counter {};
+    m_job_system->parallel_for(get_list_count(), 1, record_list, &counter);
+    m_job_system->wait(&counter);
+}
+
+void secondary_pass::execute(command_list* primary)
+{
+    primary->execute_commands(m_list_pointers.data(), get_list_count());
 }
 
 } // namespace quix
@@ -11,8 +11,41 @@ namespace graphics {
     class pipeline;
 }
 class command_list;
+class command_pool;
 class image_handle;
+class job_system;
 
+// what a queue submission waits on and signals besides the timeline of its own queue
+struct submit_dependencies {
+    struct timeline_wait {
+        timeline_point point {};
+        VkPipelineStageFlags stage = 0;
+    };
+
+    std::array<timeline_wait, queue_type_count> timeline_waits {};
+    uint32_t timeline_wait_count = 0;
+
+    // binary semaphores are only needed to talk to the swapchain
+    VkSemaphore binary_wait = VK_NULL_HANDLE;
+    VkPipelineStageFlags binary_wait_stage = 0;
+    VkSemaphore binary_signal = VK_NULL_HANDLE;
+
+    // waits on the same queue are merged so there is never more than one per queue
+    submit_dependencies& wait_for(timeline_point point, VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) noexcept
+    {
+        for (uint32_t i = 0; i < timeline_wait_count; i++) {
+            if (timeline_waits[i].point.queue == point.queue) {
+                timeline_waits[i].point.value = std::max(timeline_waits[i].point.value, point.value);
+                timeline_waits[i].stage |= stage;
+                return *this;
+            }
+        }
+        timeline_waits[timeline_wait_count++] = timeline_wait { point, stage };
+        return *this;
+    }
+};
+
+// per frame swapchain synchronization, frames are retired through the graphics timeline instead of fences
 class sync {
 public:
     sync(weakref<device> p_device, weakref<swapchain> p_swapchain);
@@ -23,12 +56,15 @@ public:
     sync(sync&&) = delete;
     const sync& operator=(sync&&) = delete;
 
-    void wait_for_fence(const int frame);
-    void reset_fence(const int frame);
+    // blocks until the last submission of this frame slot has finished on the gpu
+    void wait_for_frame(const int frame);
     VkResult acquire_next_image(const int frame, uint32_t* image_index);
-    VkResult submit_frame(const int frame, command_list* command);
+    timeline_point submit_frame(const int frame, command_list* command);
     VkResult present_frame(const int frame, const uint32_t image_index);
 
+    NODISCARD inline timeline_point get_frame_point(const int frame) const noexcept { return m_frame_points[frame]; }
+    NODISCARD inline int get_frames_in_flight() const noexcept { return m_frames_in_flight; }
+
 private:
     void create_sync_objects();
     void destroy_sync_objects();
@@ -37,10 +73,9 @@ private:
     weakref<swapchain> m_swapchain;
 
     int m_frames_in_flight;
-    void* m_sync_buffer = nullptr;
-    VkFence* m_fences = nullptr;
-    VkSemaphore* m_available_semaphores = nullptr;
-    VkSemaphore* m_finished_semaphores = nullptr;
+    std::vector<timeline_point> m_frame_points;
+    std::vector<VkSemaphore> m_available_semaphores;
+    std::vector<VkSemaphore> m_finished_semaphores;
 };
 
 struct image_barrier_info {
@@ -52,9 +87,83 @@ struct image_barrier_info {
     VkPipelineStageFlags dst_stage{};
 };
 
+struct buffer_barrier_info {
+    VkAccessFlags src_access_mask{};
+    VkAccessFlags dst_access_mask{};
+    VkPipelineStageFlags src_stage{};
+    VkPipelineStageFlags dst_stage{};
+};
+
+// one side of a synchronization2 barrier
+struct barrier_scope {
+    VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = VK_ACCESS_2_NONE;
+};
+
+// collects synchronization2 barriers and records them with a single vkCmdPipelineBarrier2, each barrier keeps its own
+// stages so unrelated resources do not wait on each other the way one pair of stage masks for a whole batch makes them,
+// barriers on the same buffer range or image subresources with the same layouts are merged into one, all global memory
+// barriers are merged into one, a subresource may only be transitioned once per batch, needs the synchronization2 feature
+class barrier_batch {
+public:
+    barrier_batch& memory(barrier_scope src, barrier_scope dst);
+    barrier_batch& buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, barrier_scope src, barrier_scope dst);
+    barrier_batch& image(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, barrier_scope src, barrier_scope dst,
+        const VkImageSubresourceRange& range);
+    // every mip level and array layer of the image
+    barrier_batch& image(const image_handle* image, VkImageLayout old_layout, VkImageLayout new_layout, barrier_scope src, barrier_scope dst,
+        VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
+
+    // records everything collected so far and clears the batch so it can be reused, nothing is recorded when it is empty
+    void flush(command_list* list);
+
+    NODISCARD inline bool empty() const noexcept { return m_memory_barriers.empty() && m_buffer_barriers.empty() && m_image_barriers.empty(); }
+    NODISCARD inline uint32_t size() const noexcept
+    {
+        return static_cast<uint32_t>(m_memory_barriers.size() + m_buffer_barriers.size() + m_image_barriers.size());
+    }
+
+private:
+    std::vector<VkMemoryBarrier2> m_memory_barriers {};
+    std::vector<VkBufferMemoryBarrier2> m_buffer_barriers {};
+    std::vector<VkImageMemoryBarrier2> m_image_barriers {};
+};
+
+// one attachment of dynamic rendering, the view has to be in layout before rendering begins, a multisampled
+// attachment is resolved into resolve_view when it is set
+struct rendering_attachment {
+    VkImageView view = VK_NULL_HANDLE;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkAttachmentStoreOp store_op = VK_ATTACHMENT_STORE_OP_STORE;
+    VkClearValue clear_value {};
+    VkImageView resolve_view = VK_NULL_HANDLE;
+    VkResolveModeFlagBits resolve_mode = VK_RESOLVE_MODE_AVERAGE_BIT;
+};
+
+// what the typed bind and draw methods of a command_list recorded since begin_record and how much redundant state they
+// dropped, descriptor sets and vertex buffers are counted per binding
+struct command_list_stats {
+    uint32_t draws = 0;
+    uint32_t state_commands = 0;
+    uint32_t filtered_pipelines = 0;
+    uint32_t filtered_descriptor_sets = 0;
+    uint32_t filtered_vertex_buffers = 0;
+    uint32_t filtered_index_buffers = 0;
+    uint32_t filtered_viewports = 0;
+    uint32_t filtered_scissors = 0;
+    uint32_t filtered_push_constants = 0;
+
+    NODISCARD inline uint32_t get_filtered() const noexcept
+    {
+        return filtered_pipelines + filtered_descriptor_sets + filtered_vertex_buffers + filtered_index_buffers
+            + filtered_viewports + filtered_scissors + filtered_push_constants;
+    }
+};
+
 class command_list {
 public:
-    command_list(weakref<device> p_device, VkCommandBuffer buffer);
+    command_list(weakref<device> p_device, VkCommandBuffer buffer, queue_type type = queue_type::graphics, command_pool* owner = nullptr, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     ~command_list() = default;
 
     command_list(const command_list&) = delete;
@@ -64,33 +173,151 @@ public:
 
     NODISCARD inline VkCommandBuffer get_cmd_buffer() const noexcept { return buffer; }
     NODISCARD inline VkCommandBuffer* get_cmd_buffer_ref() { return &buffer; }
+    NODISCARD inline queue_type get_queue_type() const noexcept { return m_queue_type; }
+    NODISCARD inline VkCommandBufferLevel get_level() const noexcept { return m_level; }
 
-    void begin_record(VkCommandBufferUsageFlags flags = 0);
+    // secondary lists recorded inside a render pass need inheritance info and VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+    void begin_record(VkCommandBufferUsageFlags flags = 0, const VkCommandBufferInheritanceInfo* inheritance_info = nullptr);
     void end_record();
 
-    void begin_render_pass(const render_target& p_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index, VkClearValue* clear_value, uint32_t clear_value_count);
+    // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS nothing but execute_commands may be recorded inside the pass,
+    // so the pipeline, viewport and scissor are left to the secondary lists and p_pipeline may be null
+    void begin_render_pass(const render_target& p_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index, VkClearValue* clear_value, uint32_t clear_value_count, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
     void end_render_pass();
 
+    // dynamic rendering straight from image views, no render pass or framebuffer is involved, with
+    // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT nothing but execute_commands may be recorded until end_rendering
+    void begin_rendering(VkExtent2D extent, const rendering_attachment* color_attachments, uint32_t color_attachment_count,
+        const rendering_attachment* depth_attachment = nullptr, const rendering_attachment* stencil_attachment = nullptr, VkRenderingFlags flags = 0);
+    // renders into the swapchain image of a dynamic render target, clear values are ordered like the attachments of a
+    // render pass, color then depth, and the layout transitions a render pass would do are recorded around it
+    void begin_rendering(const render_target& p_target, const std::shared_ptr<graphics::pipeline>& p_pipeline, uint32_t image_index,
+        const VkClearValue* clear_values, uint32_t clear_value_count, VkRenderingFlags flags = 0);
+    void end_rendering();
+
+    // graphics state is tracked from begin_record on and binds that would not change it are skipped, call
+    // invalidate_state after recording state with raw vkCmd calls on get_cmd_buffer
+    void bind_pipeline(const std::shared_ptr<graphics::pipeline>& p_pipeline);
+    // bound with the layout of the current pipeline, sets bound together with dynamic offsets are only filtered one at a time
+    void bind_descriptor_sets(uint32_t first_set, const VkDescriptorSet* sets, uint32_t set_count, const uint32_t* dynamic_offsets = nullptr, uint32_t dynamic_offset_count = 0);
+    void bind_vertex_buffers(uint32_t first_binding, const VkBuffer* buffers, const VkDeviceSize* offsets, uint32_t buffer_count);
+    void bind_vertex_buffer(VkBuffer vertex_buffer, VkDeviceSize offset = 0);
+    void bind_index_buffer(VkBuffer index_buffer, VkDeviceSize offset, VkIndexType index_type);
+    void set_viewport(const VkViewport& viewport);
+    void set_scissor(const VkRect2D& scissor);
+    void set_viewport_and_scissor(VkExtent2D extent);
+    void push_constants(VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+    void invalidate_state() noexcept;
+
+    void draw(uint32_t vertex_count, uint32_t instance_count = 1, uint32_t first_vertex = 0, uint32_t first_instance = 0);
+    void draw_indexed(uint32_t index_count, uint32_t instance_count = 1, uint32_t first_index = 0, int32_t vertex_offset = 0, uint32_t first_instance = 0);
+    // draw_count above 1 needs the multiDrawIndirect feature
+    void draw_indexed_indirect(VkBuffer command_buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand));
+    // the draw count is read from count_buffer on the gpu and clamped to max_draw_count, needs the drawIndirectCount feature
+    void draw_indexed_indirect_count(VkBuffer command_buffer, VkDeviceSize offset, VkBuffer count_buffer, VkDeviceSize count_offset,
+        uint32_t max_draw_count, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand));
+
+    NODISCARD inline const command_list_stats& get_stats() const noexcept { return m_stats; }
+
+    // the secondary lists must stay alive until this list's submission has completed, they are retired along with it
+    void execute_commands(command_list* const* lists, uint32_t list_count);
+
     void copy_buffer_to_buffer(VkBuffer src_buffer, VkDeviceSize src_offset, VkBuffer dst_buffer, VkDeviceSize dst_offset, VkDeviceSize size);
-    // if the image is something like a depth image and or a stencil image, will need VK_IMAGE_ASPECT_DEPTH_BIT and or VK_IMAGE_ASPECT_STENCIL_BIT
+    void copy_buffer_to_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, const VkBufferCopy* regions, uint32_t region_count);
+    // size and offset are multiples of 4, the buffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    void fill_buffer(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value);
+    // fills the first mip level, if the image is something like a depth image and or a stencil image, will need VK_IMAGE_ASPECT_DEPTH_BIT and or VK_IMAGE_ASPECT_STENCIL_BIT
     void copy_buffer_to_image(VkBuffer src_buffer, VkDeviceSize buffer_offset, image_handle* dst_image, VkOffset3D image_offset, VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
     // if the image is something like a depth image and or a stencil image, will need VK_IMAGE_ASPECT_DEPTH_BIT and or VK_IMAGE_ASPECT_STENCIL_BIT
+    // dst_image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    void copy_buffer_to_image(VkBuffer src_buffer, image_handle* dst_image, const VkBufferImageCopy* regions, uint32_t region_count);
+    void copy_buffer_to_image(VkBuffer src_buffer, VkImage dst_image, const VkBufferImageCopy* regions, uint32_t region_count);
+    // if the image is something like a depth image and or a stencil image, will need VK_IMAGE_ASPECT_DEPTH_BIT and or VK_IMAGE_ASPECT_STENCIL_BIT
     void copy_image_to_image(image_handle* src, VkOffset3D src_offset, image_handle* dst, VkOffset3D dst_offset, VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
 
     void image_barrier(image_handle* image, image_barrier_info* barrier_info, VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
+    // records every caller built barrier with one vkCmdPipelineBarrier
+    void pipeline_barrier(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+        const VkBufferMemoryBarrier* buffer_barriers, uint32_t buffer_barrier_count,
+        const VkImageMemoryBarrier* image_barriers, uint32_t image_barrier_count);
+    // synchronization2 barriers, usually recorded through a barrier_batch
+    void pipeline_barrier(const VkDependencyInfo* dependency_info);
 
-    void submit(VkFence fence = VK_NULL_HANDLE);
+    // queue family ownership transfer, record the release on this list and the acquire with the same barrier info on a list of dst_queue,
+    // when both queue types share a family the release does nothing and the acquire is a regular barrier
+    void release_image_ownership(image_handle* image, const image_barrier_info* barrier_info, queue_type dst_queue, VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
+    void acquire_image_ownership(image_handle* image, const image_barrier_info* barrier_info, queue_type src_queue, VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT);
+    void release_buffer_ownership(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, queue_type dst_queue);
+    void acquire_buffer_ownership(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, queue_type src_queue);
+
+    // submits to the queue this list was allocated for, the returned point is reached once the list has finished executing
+    timeline_point submit(const submit_dependencies* dependencies = nullptr);
+    NODISCARD inline timeline_point get_last_submit() const noexcept { return m_last_submit; }
 
 private:
+    static constexpr uint32_t max_tracked_sets = 4;
+    static constexpr uint32_t max_tracked_vertex_buffers = 8;
+    // the smallest maxPushConstantsSize a device may have, pushes past it are always recorded
+    static constexpr uint32_t max_tracked_push_constants = 128;
+    // the dynamic offsets of a slot are unknown when it was bound together with other sets and dynamic offsets
+    static constexpr uint32_t unknown_dynamic_offsets = std::numeric_limits<uint32_t>::max();
+
+    // what the graphics bind point of the command buffer currently holds, null handles are never bound
+    struct bound_state {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+
+        std::array<VkDescriptorSet, max_tracked_sets> descriptor_sets {};
+        std::array<uint32_t, max_tracked_sets> dynamic_offset_counts {};
+        std::array<uint32_t, max_tracked_sets> dynamic_offsets {};
+
+        std::array<VkBuffer, max_tracked_vertex_buffers> vertex_buffers {};
+        std::array<VkDeviceSize, max_tracked_vertex_buffers> vertex_offsets {};
+        VkBuffer index_buffer = VK_NULL_HANDLE;
+        VkDeviceSize index_offset = 0;
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+
+        bool viewport_valid = false;
+        bool scissor_valid = false;
+        VkViewport viewport {};
+        VkRect2D scissor {};
+
+        // bytes push_begin to push_end hold what was last pushed for push_stages
+        VkShaderStageFlags push_stages = 0;
+        uint32_t push_begin = 0;
+        uint32_t push_end = 0;
+        std::array<uint8_t, max_tracked_push_constants> push_constants {};
+    };
+
+    void record_image_barrier(image_handle* image, const image_barrier_info* barrier_info, VkImageAspectFlags aspect_mask, uint32_t src_family, uint32_t dst_family);
+    void record_buffer_barrier(VkBuffer dst_buffer, VkDeviceSize offset, VkDeviceSize size, const buffer_barrier_info* barrier_info, uint32_t src_family, uint32_t dst_family);
+
+    void track_submit(timeline_point point);
+
     weakref<device> m_device;
     VkCommandBuffer buffer;
+    queue_type m_queue_type;
+    timeline_point m_last_submit {};
+    // swapchain image moved to the present layout by end_rendering
+    VkImage m_present_image = VK_NULL_HANDLE;
+    bound_state m_state {};
+    command_list_stats m_stats {};
+    // secondary lists executed since the last begin_record
+    std::vector<command_list*> m_executed_lists {};
+    // scratch for execute_commands, cleared on every call but keeps its capacity
+    std::vector<VkCommandBuffer> m_execute_buffers {};
+    // told about every submission so the pool knows when it can be reused
+    command_pool* m_owner;
+    VkCommandBufferLevel m_level;
 };
 
 class command_pool {
     friend class instance;
 
 public:
-    command_pool(weakref<device> p_device, VkCommandPool pool);
+    // buffers are already allocated from pool and free to use, like the ones a reused pool comes back with
+    command_pool(weakref<device> p_device, VkCommandPool pool, queue_type type = queue_type::graphics, command_pool_usage usage = command_pool_usage::persistent, command_buffer_lists&& buffers = {});
+    // retires the pool to the cache of the destroying thread, it is reset once its last submission has completed
     ~command_pool();
 
     command_pool(const command_pool&) = delete;
@@ -99,13 +326,96 @@ public:
     command_pool& operator=(command_pool&&) = delete;
 
     NODISCARD inline VkCommandPool get_pool() const noexcept { return pool; }
+    NODISCARD inline queue_type get_queue_type() const noexcept { return m_queue_type; }
+    NODISCARD inline command_pool_usage get_usage() const noexcept { return m_usage; }
+    NODISCARD inline timeline_point get_last_submit() const noexcept { return m_last_submit; }
 
+    // hands out a recycled buffer when there is one, dropping the list returns its buffer to the pool,
+    // persistent pools reuse it once its submission completed, transient pools only after reset()
     NODISCARD allocated_unique_ptr<command_list> create_command_list(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
+    // resets the whole pool and makes every buffer reusable, all lists have to be dropped and their submissions completed
+    void reset();
+
+    inline void track_submit(timeline_point point) noexcept
+    {
+        m_last_submit.queue = point.queue;
+        m_last_submit.value = std::max(m_last_submit.value, point.value);
+    }
+
 private:
+    NODISCARD VkCommandBuffer acquire_buffer(VkCommandBufferLevel level);
+    void release_buffer(VkCommandBuffer buffer, VkCommandBufferLevel level, timeline_point last_submit);
+    void recycle_completed_buffers();
+
+    static constexpr uint32_t buffer_block_size = 8;
+
+    struct pending_buffer {
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        timeline_point last_submit {};
+    };
+
     std::pmr::unsynchronized_pool_resource m_allocator;
     weakref<device> m_device;
     VkCommandPool pool;
+    queue_type m_queue_type;
+    command_pool_usage m_usage;
+    timeline_point m_last_submit {};
+
+    // buffers in the initial state, ready to be handed out
+    command_buffer_lists m_free_buffers {};
+    // buffers of dropped lists, oldest first
+    std::deque<pending_buffer> m_pending_buffers {};
+    uint32_t m_live_lists = 0;
+};
+
+// splits one subpass of a render target into secondary lists that are recorded in parallel, each list has its own pool
+// so no two threads share one, keep one secondary_pass per frame in flight since the lists are re-recorded every frame
+class secondary_pass {
+public:
+    secondary_pass(weakref<device> p_device, weakref<job_system> p_job_system, uint32_t list_count, queue_type type = queue_type::graphics);
+    ~secondary_pass() = default;
+
+    secondary_pass(const secondary_pass&) = delete;
+    secondary_pass& operator=(const secondary_pass&) = delete;
+    secondary_pass(secondary_pass&&) = delete;
+    secondary_pass& operator=(secondary_pass&&) = delete;
+
+    // the lists inherit the render pass, subpass and framebuffer of the target, call before beginning any list
+    // a dynamic target is inherited through its rendering formats
+    void set_target(const render_target& target, uint32_t image_index, uint32_t subpass = 0);
+    // the lists inherit dynamic rendering with these formats, the primary begins rendering with
+    // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+    void set_target(const rendering_formats& formats, VkExtent2D extent);
+
+    // different lists may be begun, recorded and ended from different threads at the same time
+    command_list* begin_list(uint32_t index, const std::shared_ptr<graphics::pipeline>& p_pipeline);
+    void end_list(uint32_t index);
+
+    // records every list as a job, the calling thread helps out and returns once all lists are ended
+    void record_parallel(const std::shared_ptr<graphics::pipeline>& p_pipeline, const std::function<void(command_list*, uint32_t)>& record);
+
+    // primary has to be inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, or rendering
+    // begun with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+    void execute(command_list* primary);
+
+    NODISCARD inline uint32_t get_list_count() const noexcept { return static_cast<uint32_t>(m_lists.size()); }
+    NODISCARD inline command_list* get_list(uint32_t index) const noexcept { return m_lists[index].get(); }
+
+private:
+    weakref<device> m_device;
+    weakref<job_system> m_job_system;
+
+    VkCommandBufferInheritanceInfo m_inheritance_info {};
+    VkExtent2D m_extent {};
+    rendering_formats m_formats {};
+    VkCommandBufferInheritanceRenderingInfo m_rendering_inheritance {};
+
+    // declared before the lists so the lists are dropped first
+    std::vector<std::unique_ptr<command_pool>> m_pools {};
+    std::vector<allocated_unique_ptr<command_list>> m_lists {};
+    std::vector<command_list*> m_list_pointers {};
 };
 
 } // namespace quix
@@ -3,6 +3,45 @@
 
 namespace quix {
 
+// graphics is always available, compute and transfer alias the graphics queue when the device has no dedicated family for them
+enum class queue_type : uint32_t {
+    graphics = 0,
+    compute = 1,
+    transfer = 2,
+};
+
+static constexpr std::size_t queue_type_count = 3;
+
+// persistent pools allow resetting single command lists, transient pools are for short lived lists and are only reset as a whole
+enum class command_pool_usage : uint32_t {
+    persistent = 0,
+    transient = 1,
+};
+
+static constexpr std::size_t command_pool_usage_count = 2;
+
+// command buffers allocated from one pool, indexed by VkCommandBufferLevel
+using command_buffer_lists = std::array<std::vector<VkCommandBuffer>, 2>;
+
+// a value on the timeline semaphore of a queue, the gpu reaches it once every submission up to it has finished
+// value 0 is never signaled by a submission so it is always complete
+struct timeline_point {
+    queue_type queue = queue_type::graphics;
+    uint64_t value = 0;
+};
+
+// attachment formats of dynamic rendering, pipelines are built against them and secondary lists inherit them instead
+// of a render pass, any render target or set of views with the same formats can use the same pipeline
+struct rendering_formats {
+    static constexpr uint32_t max_color_attachments = 8;
+
+    std::array<VkFormat, max_color_attachments> color_formats {};
+    uint32_t color_format_count = 0;
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+    VkFormat stencil_format = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
 template <typename Type, typename... Args>
 NODISCARD static constexpr auto create_auto_array(Args&&... args)
 {
@@ -3,17 +3,75 @@
 
 #include "quix_device.hpp"
 
+#include "quix_commands.hpp"
 #include "quix_window.hpp"
 
+#include <span>
+
 namespace quix {
 
+namespace {
+
+    struct retired_command_pool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        timeline_point last_submit {};
+        command_buffer_lists buffers {};
+    };
+
+    struct thread_command_pools {
+        uint64_t device_id = 0;
+        // oldest first, only the front is checked, if it is still in flight a new pool is created instead of searching
+        std::array<std::array<std::deque<retired_command_pool>, command_pool_usage_count>, queue_type_count> retired {};
+    };
+
+    std::atomic<uint64_t> next_device_id { 1 };
+
+    // ids are never reused, so entries of destroyed devices are never matched again, each thread drops them the next
+    // time it looks up its pools after a device went away, the pools themselves are destroyed by their device
+    std::mutex live_devices_mutex;
+    std::vector<uint64_t> live_device_ids {};
+    std::atomic<uint64_t> destroyed_device_count { 0 };
+
+    thread_local std::vector<thread_command_pools> cached_command_pools {};
+    thread_local uint64_t seen_destroyed_device_count = 0;
+
+    thread_command_pools& get_thread_command_pools(uint64_t device_id)
+    {
+        const uint64_t destroyed = destroyed_device_count.load(std::memory_order_acquire);
+        if (destroyed != seen_destroyed_device_count) {
+            seen_destroyed_device_count = destroyed;
+
+            std::lock_guard<std::mutex> lock(live_devices_mutex);
+            std::erase_if(cached_command_pools, [](const thread_command_pools& pools) {
+                return std::find(live_device_ids.begin(), live_device_ids.end(), pools.device_id) == live_device_ids.end();
+            });
+        }
+
+        for (auto& pools : cached_command_pools) {
+            if (pools.device_id == device_id) {
+                return pools;
+            }
+        }
+
+        auto& pools = cached_command_pools.emplace_back();
+        pools.device_id = device_id;
+        return pools;
+    }
+
+} // namespace
+
 device::device(weakref<window> p_window,
     const char* app_name,
     uint32_t app_version,
     const char* engine_name,
     uint32_t engine_version)
     : m_window(p_window)
+    , m_id(next_device_id.fetch_add(1, std::memory_order_relaxed))
 {
+    {
+        std::lock_guard<std::mutex> lock(live_devices_mutex);
+        live_device_ids.push_back(m_id);
+    }
 
     glslang::InitializeProcess();
 
@@ -33,15 +91,43 @@ device::~device()
     }
 #endif
 
+    // nothing can be in flight anymore, so whatever is still deferred goes now
+    if (m_logical_device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(m_logical_device);
+    }
+    // a destruction may defer another one, so the list is swapped out until nothing new shows up
+    while (!m_deletions.empty()) {
+        std::vector<deferred_destroy> deletions = std::move(m_deletions);
+        m_deletions.clear();
+        for (auto& deletion : deletions) {
+            deletion.destroy();
+        }
+    }
+
     for (auto& pool : m_command_pools) {
         vkDestroyCommandPool(m_logical_device, pool, nullptr);
     }
 
+    // every thread's cached handles of the pools above are dropped on its next lookup
+    {
+        std::lock_guard<std::mutex> lock(live_devices_mutex);
+        std::erase(live_device_ids, m_id);
+    }
+    destroyed_device_count.fetch_add(1, std::memory_order_release);
+
+    for (std::size_t i = 0; i < queue_type_count; i++) {
+        if (m_timeline_index[i] == i) {
+            vkDestroySemaphore(m_logical_device, m_timelines[i].semaphore, nullptr);
+        }
+    }
+
     vmaDestroyAllocator(m_allocator);
 
     vkDestroyDevice(m_logical_device, nullptr);
 
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    if (m_surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    }
 
     vkDestroyInstance(m_instance, nullptr);
 
@@ -49,6 +135,11 @@ device::~device()
 }
 
 void device::init(std::vector<const char*>&& requested_extensions, VkPhysicalDeviceFeatures requested_features)
+{
+    init(std::move(requested_extensions), device_features { requested_features }, device_features {});
+}
+
+void device::init(std::vector<const char*>&& requested_extensions, const device_features& required_features, const device_features& preferred_features)
 {
 #ifdef _DEBUG
     quix_assert(initialized == false, "device already initialized");
@@ -56,49 +147,260 @@ void device::init(std::vector<const char*>&& requested_extensions, VkPhysicalDev
 #endif
 
     this->requested_extensions = std::move(requested_extensions);
-    this->requested_features = requested_features;
+    m_required_features = required_features;
+    m_preferred_features = preferred_features;
+    // all queue synchronization in quix is built on timeline semaphores
+    m_required_features.vulkan12.timelineSemaphore = VK_TRUE;
 
     spdlog::info("requested extensions: {}", requested_extensions.size());
 
-    create_surface();
+    if (!is_headless()) {
+        create_surface();
+    }
 
     pick_physical_device();
 
     create_logical_device();
 
+    create_timelines();
+
     create_allocator();
 }
 
-NODISCARD VkCommandPool device::get_command_pool()
+NODISCARD VkCommandPool device::acquire_command_pool(queue_type type, command_pool_usage usage, command_buffer_lists* buffers)
 {
-    if (m_command_pools.empty()) {
-        quix_assert(m_queue_family_indices.has_value(), "queue family indices not initialized");
-        VkCommandPoolCreateInfo pool_info = {
-            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-            .queueFamilyIndex = m_queue_family_indices->graphics_family.value()
-        };
+    auto& retired = get_thread_command_pools(m_id).retired[static_cast<std::size_t>(type)][static_cast<std::size_t>(usage)];
 
-        VkCommandPool pool = VK_NULL_HANDLE;
-        VK_CHECK(vkCreateCommandPool(m_logical_device, &pool_info, nullptr, &pool), "failed to create command pool");
+    if (!retired.empty() && is_complete(retired.front().last_submit)) {
+        VkCommandPool pool = retired.front().pool;
+        *buffers = std::move(retired.front().buffers);
+        retired.pop_front();
 
+        // keep the memory, the pool is about to record a similar amount of commands again
+        VK_CHECK(vkResetCommandPool(m_logical_device, pool, 0), "failed to reset command pool");
         return pool;
     }
 
-    std::lock_guard<std::mutex> lock(m_command_pool_mutex);
-    VkCommandPool pool = m_command_pools.front();
-    m_command_pools.pop_front();
+    quix_assert(m_queue_family_indices.has_value(), "queue family indices not initialized");
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = usage == command_pool_usage::transient ? VkCommandPoolCreateFlags { VK_COMMAND_POOL_CREATE_TRANSIENT_BIT } : VkCommandPoolCreateFlags { VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT },
+        .queueFamilyIndex = get_queue_family(type)
+    };
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateCommandPool(m_logical_device, &pool_info, nullptr, &pool), "failed to create command pool");
+
+    {
+        std::lock_guard<std::mutex> lock(m_command_pool_mutex);
+        m_command_pools.push_back(pool);
+    }
 
     return pool;
 }
 
-void device::return_command_pool(VkCommandPool command_pool)
+void device::retire_command_pool(VkCommandPool command_pool, queue_type type, command_pool_usage usage, timeline_point last_submit, command_buffer_lists&& buffers)
+{
+    auto& retired = get_thread_command_pools(m_id).retired[static_cast<std::size_t>(type)][static_cast<std::size_t>(usage)];
+    retired.push_back(retired_command_pool { command_pool, last_submit, std::move(buffers) });
+}
+
+NODISCARD timeline_point device::submit(queue_type type, const VkCommandBuffer* buffers, uint32_t buffer_count, const submit_dependencies* dependencies)
 {
+    auto& timeline = get_timeline(type);
+
+    // at most one timeline wait per queue and the swapchain semaphore
+    std::array<VkSemaphore, queue_type_count + 1> wait_semaphores {};
+    std::array<uint64_t, queue_type_count + 1> wait_values {};
+    std::array<VkPipelineStageFlags, queue_type_count + 1> wait_stages {};
+    uint32_t wait_count = 0;
+
+    std::array<VkSemaphore, 2> signal_semaphores {};
+    std::array<uint64_t, 2> signal_values {};
+    uint32_t signal_count = 0;
+
+    if (dependencies != nullptr) {
+        for (uint32_t i = 0; i < dependencies->timeline_wait_count; i++) {
+            const auto& wait = dependencies->timeline_waits[i];
+            if (is_complete(wait.point)) {
+                continue;
+            }
+            wait_semaphores[wait_count] = get_timeline(wait.point.queue).semaphore;
+            wait_values[wait_count] = wait.point.value;
+            wait_stages[wait_count] = wait.stage;
+            wait_count++;
+        }
+
+        if (dependencies->binary_wait != VK_NULL_HANDLE) {
+            wait_semaphores[wait_count] = dependencies->binary_wait;
+            wait_values[wait_count] = 0; // ignored for binary semaphores
+            wait_stages[wait_count] = dependencies->binary_wait_stage;
+            wait_count++;
+        }
+
+        if (dependencies->binary_signal != VK_NULL_HANDLE) {
+            signal_semaphores[signal_count] = dependencies->binary_signal;
+            signal_values[signal_count] = 0; // ignored for binary semaphores
+            signal_count++;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(timeline.submit_mutex);
+
+    const uint64_t value = timeline.last_submitted + 1;
+    signal_semaphores[signal_count] = timeline.semaphore;
+    signal_values[signal_count] = value;
+    signal_count++;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = wait_count;
+    timeline_info.pWaitSemaphoreValues = wait_values.data();
+    timeline_info.signalSemaphoreValueCount = signal_count;
+    timeline_info.pSignalSemaphoreValues = signal_values.data();
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = wait_count;
+    submit_info.pWaitSemaphores = wait_semaphores.data();
+    submit_info.pWaitDstStageMask = wait_stages.data();
+    submit_info.commandBufferCount = buffer_count;
+    submit_info.pCommandBuffers = buffers;
+    submit_info.signalSemaphoreCount = signal_count;
+    submit_info.pSignalSemaphores = signal_semaphores.data();
+
+    VK_CHECK(vkQueueSubmit(get_queue(type), 1, &submit_info, VK_NULL_HANDLE), "failed to submit command buffer");
+
+    timeline.last_submitted = value;
+    lock.unlock();
+
+    // headless use never acquires a swapchain image, so submits drive deferred destruction as well
+    collect_garbage();
+
+    return timeline_point { type, value };
+}
+
+VkResult device::present(const VkPresentInfoKHR* present_info)
+{
+    // the present queue may be any of the submit queues, aliased queues share a timeline and so its mutex
+    for (std::size_t i = 0; i < queue_type_count; i++) {
+        if (m_queues[i] == m_present_queue) {
+            std::lock_guard<std::mutex> lock(get_timeline(static_cast<queue_type>(i)).submit_mutex);
+            return vkQueuePresentKHR(m_present_queue, present_info);
+        }
+    }
+
+    return vkQueuePresentKHR(m_present_queue, present_info);
+}
+
+NODISCARD bool device::is_complete(timeline_point point)
+{
+    if (point.value <= get_timeline(point.queue).last_completed.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    return point.value <= get_completed_value(point.queue);
+}
+
+NODISCARD uint64_t device::get_completed_value(queue_type type)
+{
+    auto& timeline = get_timeline(type);
+
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(m_logical_device, timeline.semaphore, &value), "failed to get timeline semaphore value");
+
+    // other threads may race to publish, only ever move the completed value forward
+    uint64_t completed = timeline.last_completed.load(std::memory_order_relaxed);
+    while (completed < value && !timeline.last_completed.compare_exchange_weak(completed, value, std::memory_order_release, std::memory_order_relaxed)) { }
+
+    return std::max(completed, value);
+}
+
+void device::wait(timeline_point point)
+{
+    if (is_complete(point)) {
+        return;
+    }
+
+    auto& timeline = get_timeline(point.queue);
+
+    VkSemaphoreWaitInfo wait_info {};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline.semaphore;
+    wait_info.pValues = &point.value;
+
+    VK_CHECK(vkWaitSemaphores(m_logical_device, &wait_info, UINT64_MAX), "failed to wait for timeline semaphore");
+
+    uint64_t completed = timeline.last_completed.load(std::memory_order_relaxed);
+    while (completed < point.value && !timeline.last_completed.compare_exchange_weak(completed, point.value, std::memory_order_release, std::memory_order_relaxed)) { }
+
+    collect_garbage();
+}
+
+NODISCARD timeline_point device::get_last_submitted(queue_type type)
+{
+    auto& timeline = get_timeline(type);
+    std::lock_guard<std::mutex> lock(timeline.submit_mutex);
+    return timeline_point { type, timeline.last_submitted };
+}
+
+void device::defer_destroy(std::function<void()>&& destroy)
+{
+    deferred_destroy deletion { {}, std::move(destroy) };
+    for (std::size_t i = 0; i < queue_type_count; i++) {
+        if (m_timeline_index[i] == i) {
+            deletion.values[i] = get_last_submitted(static_cast<queue_type>(i)).value;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_deletion_mutex);
+    m_deletions.push_back(std::move(deletion));
+}
+
+void device::defer_destroy(timeline_point last_use, std::function<void()>&& destroy)
+{
+    deferred_destroy deletion { {}, std::move(destroy) };
+    deletion.values[m_timeline_index[static_cast<std::size_t>(last_use.queue)]] = last_use.value;
+
+    std::lock_guard<std::mutex> lock(m_deletion_mutex);
+    m_deletions.push_back(std::move(deletion));
+}
+
+void device::collect_garbage()
+{
+    std::vector<deferred_destroy> completed {};
     {
-        std::lock_guard<std::mutex> lock(m_command_pool_mutex); // TODO determine if it is worth it to release resources
-        vkResetCommandPool(m_logical_device, command_pool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT);
-        m_command_pools.push_back(command_pool);
+        std::lock_guard<std::mutex> lock(m_deletion_mutex);
+        if (m_deletions.empty()) {
+            return;
+        }
+
+        // one semaphore query per timeline instead of one per pending deletion
+        std::array<uint64_t, queue_type_count> completed_values {};
+        for (std::size_t i = 0; i < queue_type_count; i++) {
+            if (m_timeline_index[i] == i) {
+                completed_values[i] = get_completed_value(static_cast<queue_type>(i));
+            }
+        }
+
+        const auto completed_begin = std::partition(m_deletions.begin(), m_deletions.end(), [&completed_values](const deferred_destroy& deletion) {
+            for (std::size_t i = 0; i < queue_type_count; i++) {
+                if (deletion.values[i] > completed_values[i]) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        completed.assign(std::make_move_iterator(completed_begin), std::make_move_iterator(m_deletions.end()));
+        m_deletions.erase(completed_begin, m_deletions.end());
+    }
+
+    // outside the lock, a destructor may defer something of its own
+    for (auto& deletion : completed) {
+        deletion.destroy();
     }
 }
 
@@ -117,8 +419,12 @@ void device::create_instance(const char* app_name,
         .apiVersion = vk_api_version
     };
 
+    // headless devices never touch glfw, so they do not need any surface extensions
     uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    const char** glfwExtensions = nullptr;
+    if (!is_headless()) {
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    }
 
     VkInstanceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
@@ -156,27 +462,39 @@ device::find_queue_families(VkPhysicalDevice physical_device)
     vkGetPhysicalDeviceQueueFamilyProperties(
         physical_device, &queueFamilyCount, queueFamiliesProperties.data());
 
-    int iterator = 0;
+    // every family is visited so the dedicated compute and transfer families are found even after graphics/present are complete
+    uint32_t iterator = 0;
     for (const auto& queueFamily : queueFamiliesProperties) {
-        if (((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0U) && ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0U)) {
+        const bool graphics = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0U;
+        const bool compute = (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0U;
+        const bool transfer = (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0U;
+
+        if (graphics && compute && !indices.graphics_family.has_value()) {
             indices.graphics_family = iterator;
         }
 
-        VkBool32 presentSupport = VK_FALSE;
-        VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(
-            physical_device, iterator, m_surface, &presentSupport), "failed to check physical device surface support");
-        if (presentSupport != 0U) {
-            indices.present_family = iterator;
+        if (compute && !graphics && !indices.compute_family.has_value()) {
+            indices.compute_family = iterator;
         }
 
-        if (indices.is_complete()) {
-            break;
+        if (transfer && !graphics && !compute && !indices.transfer_family.has_value()) {
+            indices.transfer_family = iterator;
+        }
+
+        if (!is_headless()) {
+            VkBool32 presentSupport = VK_FALSE;
+            VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(
+                physical_device, iterator, m_surface, &presentSupport), "failed to check physical device surface support");
+            // prefer presenting from the graphics family so the swapchain images do not need to be shared
+            if (presentSupport != 0U && (!indices.present_family.has_value() || indices.graphics_family == iterator)) {
+                indices.present_family = iterator;
+            }
         }
 
         iterator++;
     }
 
-    quix_assert(indices.is_complete(), "failed to find queue families");
+    quix_assert(indices.is_complete(is_headless()), "failed to find queue families");
 
     return indices;
 }
@@ -237,104 +555,116 @@ device::query_swapchain_support(VkPhysicalDevice physical_device)
     return details;
 }
 
+NODISCARD device_features device::get_supported_features(VkPhysicalDevice physical_device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    device_features supported {};
+    supported.api_version = properties.apiVersion;
+    supported.link();
+
+    vkGetPhysicalDeviceFeatures2(physical_device, supported.chain());
+
+    return supported;
+}
+
 bool device::is_physical_device_suitable(VkPhysicalDevice physical_device)
 {
     queue_family_indices indices = this->find_queue_families(physical_device);
 
     bool extensions_supported = check_device_extension_support(physical_device);
 
-    bool swapchain_adequate = false;
-    if (extensions_supported) {
+    bool swapchain_adequate = is_headless();
+    if (extensions_supported && !is_headless()) {
         swapchain_support_details swap_chain_support = query_swapchain_support(physical_device);
         swapchain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
     }
 
-    return indices.is_complete() && extensions_supported && swapchain_adequate;
+    // the 1.1 and 1.2 feature structs and timeline semaphores need at least 1.2
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    bool api_supported = properties.apiVersion >= VK_API_VERSION_1_2;
+
+    return indices.is_complete(is_headless()) && extensions_supported && swapchain_adequate && api_supported;
 }
 
-#define CHECK_VKDEVICE_FEATURE(feature)                                                  \
-    {                                                                                    \
-        if (supported_features.feature == false && requested_features.feature == true) { \
-            return 0;                                                                    \
-        } else {                                                                         \
-            if (requested_features.feature == true)                                      \
-                features_score += 100;                                                   \
-            else {                                                                       \
-                features_score += 10;                                                    \
-            }                                                                            \
-        }                                                                                \
+namespace {
+
+    // every feature struct is a header followed by nothing but VkBool32 members
+    inline std::span<VkBool32> feature_bits(VkBool32* first, VkBool32* last) noexcept
+    {
+        return { first, static_cast<std::size_t>(last - first) + 1 };
     }
 
+    inline std::array<std::span<VkBool32>, 4> feature_bits(device_features& features) noexcept
+    {
+        return {
+            feature_bits(&features.core.features.robustBufferAccess, &features.core.features.inheritedQueries),
+            feature_bits(&features.vulkan11.storageBuffer16BitAccess, &features.vulkan11.shaderDrawParameters),
+            feature_bits(&features.vulkan12.samplerMirrorClampToEdge, &features.vulkan12.subgroupBroadcastDynamicId),
+            feature_bits(&features.vulkan13.robustImageAccess, &features.vulkan13.maintenance4)
+        };
+    }
+
+} // namespace
+
 int device::get_supported_feature_score(VkPhysicalDevice physical_device)
 {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2) {
+        return 0;
+    }
+
     int features_score = 0;
 
-    // if (requested_features == nullptr) {
-    //     return features_score;
-    // }
-
-    VkPhysicalDeviceFeatures supported_features;
-    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
-
-    CHECK_VKDEVICE_FEATURE(robustBufferAccess);
-    CHECK_VKDEVICE_FEATURE(fullDrawIndexUint32);
-    CHECK_VKDEVICE_FEATURE(imageCubeArray);
-    CHECK_VKDEVICE_FEATURE(independentBlend);
-    CHECK_VKDEVICE_FEATURE(geometryShader);
-    CHECK_VKDEVICE_FEATURE(tessellationShader);
-    CHECK_VKDEVICE_FEATURE(sampleRateShading);
-    CHECK_VKDEVICE_FEATURE(dualSrcBlend);
-    CHECK_VKDEVICE_FEATURE(logicOp);
-    CHECK_VKDEVICE_FEATURE(multiDrawIndirect);
-    CHECK_VKDEVICE_FEATURE(drawIndirectFirstInstance);
-    CHECK_VKDEVICE_FEATURE(depthClamp);
-    CHECK_VKDEVICE_FEATURE(depthBiasClamp);
-    CHECK_VKDEVICE_FEATURE(fillModeNonSolid);
-    CHECK_VKDEVICE_FEATURE(depthBounds);
-    CHECK_VKDEVICE_FEATURE(wideLines);
-    CHECK_VKDEVICE_FEATURE(largePoints);
-    CHECK_VKDEVICE_FEATURE(alphaToOne);
-    CHECK_VKDEVICE_FEATURE(multiViewport);
-    CHECK_VKDEVICE_FEATURE(samplerAnisotropy);
-    CHECK_VKDEVICE_FEATURE(textureCompressionETC2);
-    CHECK_VKDEVICE_FEATURE(textureCompressionASTC_LDR);
-    CHECK_VKDEVICE_FEATURE(textureCompressionBC);
-    CHECK_VKDEVICE_FEATURE(occlusionQueryPrecise);
-    CHECK_VKDEVICE_FEATURE(pipelineStatisticsQuery);
-    CHECK_VKDEVICE_FEATURE(vertexPipelineStoresAndAtomics);
-    CHECK_VKDEVICE_FEATURE(fragmentStoresAndAtomics);
-    CHECK_VKDEVICE_FEATURE(shaderTessellationAndGeometryPointSize);
-    CHECK_VKDEVICE_FEATURE(shaderImageGatherExtended);
-    CHECK_VKDEVICE_FEATURE(shaderStorageImageExtendedFormats);
-    CHECK_VKDEVICE_FEATURE(shaderStorageImageMultisample);
-    CHECK_VKDEVICE_FEATURE(shaderStorageImageReadWithoutFormat);
-    CHECK_VKDEVICE_FEATURE(shaderStorageImageWriteWithoutFormat);
-    CHECK_VKDEVICE_FEATURE(shaderUniformBufferArrayDynamicIndexing);
-    CHECK_VKDEVICE_FEATURE(shaderSampledImageArrayDynamicIndexing);
-    CHECK_VKDEVICE_FEATURE(shaderStorageBufferArrayDynamicIndexing);
-    CHECK_VKDEVICE_FEATURE(shaderStorageImageArrayDynamicIndexing);
-    CHECK_VKDEVICE_FEATURE(shaderClipDistance);
-    CHECK_VKDEVICE_FEATURE(shaderCullDistance);
-    CHECK_VKDEVICE_FEATURE(shaderFloat64);
-    CHECK_VKDEVICE_FEATURE(shaderInt64);
-    CHECK_VKDEVICE_FEATURE(shaderInt16);
-    CHECK_VKDEVICE_FEATURE(shaderResourceResidency);
-    CHECK_VKDEVICE_FEATURE(shaderResourceMinLod);
-    CHECK_VKDEVICE_FEATURE(sparseBinding);
-    CHECK_VKDEVICE_FEATURE(sparseResidencyBuffer);
-    CHECK_VKDEVICE_FEATURE(sparseResidencyImage2D);
-    CHECK_VKDEVICE_FEATURE(sparseResidencyImage3D);
-    CHECK_VKDEVICE_FEATURE(sparseResidency2Samples);
-    CHECK_VKDEVICE_FEATURE(sparseResidency4Samples);
-    CHECK_VKDEVICE_FEATURE(sparseResidency8Samples);
-    CHECK_VKDEVICE_FEATURE(sparseResidency16Samples);
-    CHECK_VKDEVICE_FEATURE(sparseResidencyAliased);
-    CHECK_VKDEVICE_FEATURE(variableMultisampleRate);
-    CHECK_VKDEVICE_FEATURE(inheritedQueries);
+    device_features supported_features = get_supported_features(physical_device);
+
+    auto supported = feature_bits(supported_features);
+    auto required = feature_bits(m_required_features);
+    auto preferred = feature_bits(m_preferred_features);
+
+    for (std::size_t i = 0; i < supported.size(); i++) {
+        for (std::size_t bit = 0; bit < supported[i].size(); bit++) {
+            if (required[i][bit] == VK_TRUE) {
+                if (supported[i][bit] != VK_TRUE) {
+                    return 0;
+                }
+                features_score += 100;
+            } else if (supported[i][bit] == VK_TRUE) {
+                features_score += preferred[i][bit] == VK_TRUE ? 50 : 10;
+            }
+        }
+    }
 
     return features_score;
 }
 
+void device::select_enabled_features()
+{
+    m_enabled_features = get_supported_features(m_physical_device);
+
+    auto enabled = feature_bits(m_enabled_features);
+    auto required = feature_bits(m_required_features);
+    auto preferred = feature_bits(m_preferred_features);
+
+    uint32_t preferred_count = 0;
+    uint32_t preferred_enabled = 0;
+    for (std::size_t i = 0; i < enabled.size(); i++) {
+        for (std::size_t bit = 0; bit < enabled[i].size(); bit++) {
+            const bool supported = enabled[i][bit] == VK_TRUE;
+            if (preferred[i][bit] == VK_TRUE && required[i][bit] != VK_TRUE) {
+                preferred_count++;
+                preferred_enabled += supported ? 1 : 0;
+            }
+            enabled[i][bit] = (required[i][bit] == VK_TRUE || (preferred[i][bit] == VK_TRUE && supported)) ? VK_TRUE : VK_FALSE;
+        }
+    }
+
+    spdlog::info("enabled {} of {} preferred device features", preferred_enabled, preferred_count);
+}
+
 int device::rate_physical_device(VkPhysicalDevice physical_device)
 {
     int score = get_supported_feature_score(physical_device);
@@ -425,6 +755,7 @@ void device::pick_physical_device()
             VkPhysicalDeviceProperties properties;
             vkGetPhysicalDeviceProperties(m_physical_device, &properties);
             max_sampler_anisotropy = properties.limits.maxSamplerAnisotropy;
+            select_enabled_features();
             spdlog::info("Using device: {} with a score of {}", properties.deviceName, deviceRating.first);
 
             // maxMsaa = getMaxUsableSampleCount(); // TODO
@@ -440,7 +771,16 @@ void device::create_logical_device()
     queue_family_indices indices = find_queue_families(m_physical_device);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = { indices.graphics_family.value(), indices.present_family.value() };
+    std::set<uint32_t> uniqueQueueFamilies = { indices.graphics_family.value() };
+    if (indices.present_family.has_value()) {
+        uniqueQueueFamilies.insert(indices.present_family.value());
+    }
+    if (indices.compute_family.has_value()) {
+        uniqueQueueFamilies.insert(indices.compute_family.value());
+    }
+    if (indices.transfer_family.has_value()) {
+        uniqueQueueFamilies.insert(indices.transfer_family.value());
+    }
 
     float queuePriority = 1.0f;
     for (const uint32_t queueFamily : uniqueQueueFamilies) {
@@ -460,15 +800,46 @@ void device::create_logical_device()
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-    createInfo.pEnabledFeatures = &requested_features;
+    // the features are passed through the pNext chain, pEnabledFeatures has to stay null
+    createInfo.pEnabledFeatures = nullptr;
+    createInfo.pNext = m_enabled_features.chain();
 
     createInfo.enabledExtensionCount = static_cast<uint32_t>(requested_extensions.size());
     createInfo.ppEnabledExtensionNames = requested_extensions.data();
 
     VK_CHECK(vkCreateDevice(m_physical_device, &createInfo, nullptr, &m_logical_device), "failed to create a logical device");
 
-    vkGetDeviceQueue(m_logical_device, indices.graphics_family.value(), 0, &m_graphics_queue);
-    vkGetDeviceQueue(m_logical_device, indices.present_family.value(), 0, &m_present_queue);
+    m_queue_families[static_cast<std::size_t>(queue_type::graphics)] = indices.graphics_family.value();
+    m_queue_families[static_cast<std::size_t>(queue_type::compute)] = indices.compute_family.value_or(indices.graphics_family.value());
+    m_queue_families[static_cast<std::size_t>(queue_type::transfer)] = indices.transfer_family.value_or(indices.graphics_family.value());
+
+    for (std::size_t i = 0; i < queue_type_count; i++) {
+        vkGetDeviceQueue(m_logical_device, m_queue_families[i], 0, &m_queues[i]);
+    }
+
+    spdlog::info("dedicated compute queue: {}, dedicated transfer queue: {}", has_dedicated_queue(queue_type::compute), has_dedicated_queue(queue_type::transfer));
+    if (indices.present_family.has_value()) {
+        vkGetDeviceQueue(m_logical_device, indices.present_family.value(), 0, &m_present_queue);
+    }
+}
+
+void device::create_timelines()
+{
+    VkSemaphoreTypeCreateInfo type_info {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
+    for (std::size_t i = 0; i < queue_type_count; i++) {
+        m_timeline_index[i] = has_dedicated_queue(static_cast<queue_type>(i)) ? i : static_cast<std::size_t>(queue_type::graphics);
+        if (m_timeline_index[i] == i) {
+            VK_CHECK(vkCreateSemaphore(m_logical_device, &semaphore_info, nullptr, &m_timelines[i].semaphore), "failed to create timeline semaphore");
+        }
+    }
 }
 
 void device::create_allocator()
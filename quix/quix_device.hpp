@@ -5,14 +5,76 @@ namespace quix {
 
 class window;
 class swapchain;
+struct submit_dependencies;
 
 struct queue_family_indices {
     std::optional<uint32_t> graphics_family;
     std::optional<uint32_t> present_family;
+    // only set when the device has a compute family without graphics
+    std::optional<uint32_t> compute_family;
+    // only set when the device has a transfer family without graphics or compute
+    std::optional<uint32_t> transfer_family;
 
-    NODISCARD bool is_complete() const
+    // a headless device has no surface, so it only needs a graphics capable family
+    NODISCARD bool is_complete(bool headless) const
     {
-        return graphics_family.has_value() && present_family.has_value();
+        return graphics_family.has_value() && (headless || present_family.has_value());
+    }
+};
+
+// a VkPhysicalDeviceFeatures2 chain holding the 1.1 - 1.3 feature structs, copies link their own chain
+struct device_features {
+    VkPhysicalDeviceFeatures2 core {};
+    VkPhysicalDeviceVulkan11Features vulkan11 {};
+    VkPhysicalDeviceVulkan12Features vulkan12 {};
+    VkPhysicalDeviceVulkan13Features vulkan13 {};
+
+    // the 1.3 struct is only chained when the api version is at least 1.3
+    uint32_t api_version = VK_API_VERSION_1_3;
+
+    device_features() noexcept { link(); }
+    explicit device_features(const VkPhysicalDeviceFeatures& features) noexcept
+        : device_features()
+    {
+        core.features = features;
+    }
+
+    device_features(const device_features& other) noexcept
+        : core(other.core)
+        , vulkan11(other.vulkan11)
+        , vulkan12(other.vulkan12)
+        , vulkan13(other.vulkan13)
+        , api_version(other.api_version)
+    {
+        link();
+    }
+
+    device_features& operator=(const device_features& other) noexcept
+    {
+        core = other.core;
+        vulkan11 = other.vulkan11;
+        vulkan12 = other.vulkan12;
+        vulkan13 = other.vulkan13;
+        api_version = other.api_version;
+        link();
+        return *this;
+    }
+
+    ~device_features() = default;
+
+    NODISCARD inline VkPhysicalDeviceFeatures2* chain() noexcept { return &core; }
+
+    inline void link() noexcept
+    {
+        core.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        vulkan11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+        vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+        core.pNext = &vulkan11;
+        vulkan11.pNext = &vulkan12;
+        vulkan12.pNext = api_version >= VK_API_VERSION_1_3 ? &vulkan13 : nullptr;
+        vulkan13.pNext = nullptr;
     }
 };
 
@@ -26,6 +88,7 @@ class device {
     friend class swapchain;
 
 public:
+    // p_window may be null, in which case the device is headless and never creates a surface
     device(weakref<window> p_window,
         const char* app_name,
         uint32_t app_version,
@@ -35,6 +98,8 @@ public:
     ~device();
 
     void init(std::vector<const char*>&& requested_extensions, VkPhysicalDeviceFeatures requested_features);
+    // required features make a device unsuitable when missing, preferred features are only enabled where supported
+    void init(std::vector<const char*>&& requested_extensions, const device_features& required_features, const device_features& preferred_features);
 
     device(const device&) = delete;
     device& operator=(const device&) = delete;
@@ -46,15 +111,48 @@ public:
     NODISCARD VkDevice get_logical_device() const noexcept { return m_logical_device; }
     NODISCARD VmaAllocator get_allocator() const noexcept { return m_allocator; }
     NODISCARD queue_family_indices get_queue_family_indices() const noexcept { return m_queue_family_indices.value(); }
-    NODISCARD VkQueue get_graphics_queue() const noexcept { return m_graphics_queue; }
+    NODISCARD VkQueue get_graphics_queue() const noexcept { return get_queue(queue_type::graphics); }
+    NODISCARD VkQueue get_compute_queue() const noexcept { return get_queue(queue_type::compute); }
+    NODISCARD VkQueue get_transfer_queue() const noexcept { return get_queue(queue_type::transfer); }
     NODISCARD VkQueue get_present_queue() const noexcept { return m_present_queue; }
+    NODISCARD VkQueue get_queue(queue_type type) const noexcept { return m_queues[static_cast<std::size_t>(type)]; }
+    NODISCARD uint32_t get_queue_family(queue_type type) const noexcept { return m_queue_families[static_cast<std::size_t>(type)]; }
+    // false when the queue type aliases the graphics queue
+    NODISCARD bool has_dedicated_queue(queue_type type) const noexcept { return type == queue_type::graphics || get_queue_family(type) != get_queue_family(queue_type::graphics); }
     NODISCARD float get_max_sampler_anisotropy() const noexcept { return max_sampler_anisotropy; }
+    // the required features plus every supported preferred feature, check it to pick fast paths at runtime
+    NODISCARD const device_features& get_enabled_features() const noexcept { return m_enabled_features; }
+    NODISCARD bool is_headless() const noexcept { return m_window.get() == nullptr; }
+
+    // pools are cached per thread, a retired pool is handed out again by the thread that retired it
+    // once its last submission has completed, so recording threads never share a pool or a lock
+    // buffers receives the command buffers a reused pool already allocated, they are reset along with the pool
+    NODISCARD VkCommandPool acquire_command_pool(queue_type type, command_pool_usage usage, command_buffer_lists* buffers);
+    void retire_command_pool(VkCommandPool command_pool, queue_type type, command_pool_usage usage, timeline_point last_submit, command_buffer_lists&& buffers);
 
-    NODISCARD VkCommandPool get_command_pool();
-    void return_command_pool(VkCommandPool command_pool);
+    // unique for the lifetime of the process, unlike the address of the device
+    NODISCARD uint64_t get_id() const noexcept { return m_id; }
 
     inline void wait_idle() { vkDeviceWaitIdle(m_logical_device); }
 
+    // every queue owns a timeline semaphore, each submission signals the next value on it
+    NODISCARD timeline_point submit(queue_type type, const VkCommandBuffer* buffers, uint32_t buffer_count, const submit_dependencies* dependencies = nullptr);
+    // presenting is serialized with submissions to whichever submit queue the present queue is, if any
+    VkResult present(const VkPresentInfoKHR* present_info);
+
+    NODISCARD bool is_complete(timeline_point point);
+    void wait(timeline_point point);
+    NODISCARD timeline_point get_last_submitted(queue_type type);
+
+    // destroy runs once every submission made so far on any queue has completed, so objects can be dropped while
+    // submitted work may still use them without idling the device, lists that are recorded but not yet submitted are
+    // not covered and must be submitted before the objects they use are dropped
+    void defer_destroy(std::function<void()>&& destroy);
+    // destroy runs once last_use has been reached
+    void defer_destroy(timeline_point last_use, std::function<void()>&& destroy);
+    // runs every deferred destruction whose submissions have completed, called by submit, wait and sync's image acquire
+    void collect_garbage();
+
 private:
     void create_instance(const char* app_name,
         uint32_t app_version,
@@ -70,10 +168,27 @@ private:
 
     bool is_physical_device_suitable(VkPhysicalDevice physical_device);
     int get_supported_feature_score(VkPhysicalDevice physical_device);
+    void select_enabled_features();
     int rate_physical_device(VkPhysicalDevice physical_device);
     void pick_physical_device();
     void create_logical_device();
     void create_allocator();
+    void create_timelines();
+
+    NODISCARD device_features get_supported_features(VkPhysicalDevice physical_device);
+
+    struct queue_timeline {
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        // guarded by submit_mutex, which also provides the external synchronization vkQueueSubmit needs
+        uint64_t last_submitted = 0;
+        std::atomic<uint64_t> last_completed { 0 };
+        std::mutex submit_mutex;
+    };
+
+    // queue types without a dedicated queue share the timeline of the graphics queue
+    NODISCARD inline queue_timeline& get_timeline(queue_type type) noexcept { return m_timelines[m_timeline_index[static_cast<std::size_t>(type)]]; }
+    // queries the semaphore and publishes the result to last_completed
+    NODISCARD uint64_t get_completed_value(queue_type type);
 
     // instance variables
 
@@ -90,19 +205,37 @@ private:
 
     VmaAllocator m_allocator = VK_NULL_HANDLE;
 
-    VkQueue m_graphics_queue = VK_NULL_HANDLE;
+    std::array<VkQueue, queue_type_count> m_queues {};
+    std::array<uint32_t, queue_type_count> m_queue_families {};
     VkQueue m_present_queue = VK_NULL_HANDLE;
 
+    std::array<queue_timeline, queue_type_count> m_timelines {};
+    std::array<std::size_t, queue_type_count> m_timeline_index {};
+
     static constexpr uint32_t vk_api_version = VK_API_VERSION_1_3;
 
     std::vector<const char*> requested_extensions {};
-    VkPhysicalDeviceFeatures requested_features {};
+    device_features m_required_features {};
+    device_features m_preferred_features {};
+    device_features m_enabled_features {};
 
     std::optional<queue_family_indices> m_queue_family_indices {};
     float max_sampler_anisotropy{};
 
-    std::deque<VkCommandPool> m_command_pools {};
+    uint64_t m_id;
+
+    // every pool ever created, only touched when a thread has to create a new pool
+    std::vector<VkCommandPool> m_command_pools {};
     std::mutex m_command_pool_mutex {};
+
+    // values are indexed like m_timelines, 0 means the deletion does not wait on that timeline
+    struct deferred_destroy {
+        std::array<uint64_t, queue_type_count> values {};
+        std::function<void()> destroy;
+    };
+
+    std::mutex m_deletion_mutex {};
+    std::vector<deferred_destroy> m_deletions {};
 };
 
 } // namespace quix
@@ -0,0 +1,75 @@
+#ifndef _QUIX_FRAME_ALLOCATOR_CPP
+#define _QUIX_FRAME_ALLOCATOR_CPP
+
+#include "quix_frame_allocator.hpp"
+
+#include "quix_device.hpp"
+
+namespace quix {
+
+frame_allocator::frame_allocator(weakref<device> p_device, int frames_in_flight, VkDeviceSize frame_size, VkBufferUsageFlags usage)
+    : m_device(std::move(p_device))
+    , m_buffer(m_device)
+    , m_frames_in_flight(frames_in_flight)
+    , m_frame_size(frame_size)
+{
+    quix_assert(frames_in_flight > 0, "a frame allocator needs at least one frame");
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->get_physical_device(), &properties);
+
+    if ((usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) != 0) {
+        m_alignment = std::max(m_alignment, properties.limits.minUniformBufferOffsetAlignment);
+    }
+    if ((usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0) {
+        m_alignment = std::max(m_alignment, properties.limits.minStorageBufferOffsetAlignment);
+    }
+    // keeps every frame region starting on an aligned offset, the limits are powers of two
+    m_frame_size = (m_frame_size + m_alignment - 1) & ~(m_alignment - 1);
+    quix_assert(m_frame_size * static_cast<VkDeviceSize>(frames_in_flight) <= std::numeric_limits<uint32_t>::max(),
+        "dynamic offsets are 32 bit, the allocator is too large");
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = m_frame_size * static_cast<VkDeviceSize>(frames_in_flight);
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo alloc_info {};
+    alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+    alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+
+    m_buffer.create_buffer(&buffer_info, &alloc_info);
+}
+
+void frame_allocator::begin_frame(int frame)
+{
+    quix_assert(frame >= 0 && frame < m_frames_in_flight, "frame is out of range");
+
+    m_frame_begin = m_frame_size * static_cast<VkDeviceSize>(frame);
+    m_head.store(0, std::memory_order_relaxed);
+}
+
+void frame_allocator::end_frame()
+{
+    const VkDeviceSize used = std::min(m_head.load(std::memory_order_acquire), m_frame_size);
+    if (used != 0) {
+        m_buffer.flush(m_frame_begin, used);
+    }
+}
+
+NODISCARD frame_allocation frame_allocator::allocate(VkDeviceSize size)
+{
+    const VkDeviceSize aligned_size = (size + m_alignment - 1) & ~(m_alignment - 1);
+    const VkDeviceSize offset = m_head.fetch_add(aligned_size, std::memory_order_relaxed);
+    quix_assert(offset + aligned_size <= m_frame_size, "frame allocator is out of space");
+
+    frame_allocation allocation {};
+    allocation.data = static_cast<char*>(m_buffer.get_mapped_data()) + m_frame_begin + offset;
+    allocation.offset = static_cast<uint32_t>(m_frame_begin + offset);
+    return allocation;
+}
+
+} // namespace quix
+
+#endif // _QUIX_FRAME_ALLOCATOR_CPP
@@ -0,0 +1,75 @@
+#ifndef _QUIX_FRAME_ALLOCATOR_HPP
+#define _QUIX_FRAME_ALLOCATOR_HPP
+
+#include "quix_resource.hpp"
+
+namespace quix {
+
+class device;
+
+struct frame_allocation {
+    void* data = nullptr;
+    // from the start of the allocator's buffer, passed as the dynamic offset of a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding
+    uint32_t offset = 0;
+};
+
+// one persistently mapped buffer split into a region per frame in flight, allocations bump an offset through the region
+// of the current frame so per draw constants need neither a buffer nor a descriptor set of their own, the data of a frame
+// slot stays valid until the slot is begun again, by then sync has already waited for the frame that read it
+class frame_allocator {
+public:
+    frame_allocator(weakref<device> p_device, int frames_in_flight, VkDeviceSize frame_size,
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+    frame_allocator(const frame_allocator&) = delete;
+    frame_allocator& operator=(const frame_allocator&) = delete;
+    frame_allocator(frame_allocator&&) = delete;
+    frame_allocator& operator=(frame_allocator&&) = delete;
+
+    // hands the region of frame back, everything allocated the last time it was begun must no longer be in use
+    void begin_frame(int frame);
+    // flushes what was written this frame in case the memory is not host coherent, call before submitting the frame
+    void end_frame();
+
+    // aligned to minUniformBufferOffsetAlignment, or minStorageBufferOffsetAlignment for storage buffers, safe to call
+    // from several threads recording the same frame
+    NODISCARD frame_allocation allocate(VkDeviceSize size);
+
+    template <typename Type>
+    NODISCARD frame_allocation push(const Type& value)
+    {
+        frame_allocation allocation = allocate(sizeof(Type));
+        std::memcpy(allocation.data, &value, sizeof(Type));
+        return allocation;
+    }
+
+    // range is the size the shader sees at each dynamic offset, usually the size of one pushed struct
+    NODISCARD inline VkDescriptorBufferInfo get_descriptor_info(VkDeviceSize range) const noexcept
+    {
+        VkDescriptorBufferInfo info {};
+        info.buffer = m_buffer.get_buffer();
+        info.offset = 0;
+        info.range = range;
+        return info;
+    }
+
+    NODISCARD inline VkBuffer get_buffer() const noexcept { return m_buffer.get_buffer(); }
+    NODISCARD inline VkDeviceSize get_frame_size() const noexcept { return m_frame_size; }
+    NODISCARD inline VkDeviceSize get_alignment() const noexcept { return m_alignment; }
+    // bytes allocated in the current frame including alignment padding
+    NODISCARD inline VkDeviceSize get_frame_usage() const noexcept { return m_head.load(std::memory_order_relaxed); }
+
+private:
+    weakref<device> m_device;
+    buffer_handle m_buffer;
+    int m_frames_in_flight;
+    VkDeviceSize m_frame_size;
+    VkDeviceSize m_alignment = 1;
+
+    VkDeviceSize m_frame_begin = 0;
+    std::atomic<VkDeviceSize> m_head { 0 };
+};
+
+} // namespace quix
+
+#endif // _QUIX_FRAME_ALLOCATOR_HPP
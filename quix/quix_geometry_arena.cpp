@@ -0,0 +1,292 @@
+#ifndef _QUIX_GEOMETRY_ARENA_CPP
+#define _QUIX_GEOMETRY_ARENA_CPP
+
+#include "quix_geometry_arena.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+#include "quix_upload.hpp"
+
+namespace quix {
+
+namespace {
+
+    NODISCARD VmaVirtualBlock create_virtual_block(uint32_t capacity)
+    {
+        VmaVirtualBlockCreateInfo block_info {};
+        block_info.size = capacity;
+
+        VmaVirtualBlock block = VK_NULL_HANDLE;
+        VK_CHECK(vmaCreateVirtualBlock(&block_info, &block), "failed to create virtual block");
+        return block;
+    }
+
+    NODISCARD bool allocate_range(VmaVirtualBlock block, uint32_t count, VmaVirtualAllocation* allocation, uint32_t* first)
+    {
+        VmaVirtualAllocationCreateInfo alloc_info {};
+        alloc_info.size = count;
+        alloc_info.alignment = 1;
+
+        VkDeviceSize offset = 0;
+        if (vmaVirtualAllocate(block, &alloc_info, allocation, &offset) != VK_SUCCESS) {
+            return false;
+        }
+
+        *first = static_cast<uint32_t>(offset);
+        return true;
+    }
+
+    NODISCARD uint32_t get_free_count(VmaVirtualBlock block, uint32_t capacity)
+    {
+        VmaStatistics statistics {};
+        vmaGetVirtualBlockStatistics(block, &statistics);
+        return capacity - static_cast<uint32_t>(statistics.allocationBytes);
+    }
+
+} // namespace
+
+geometry_arena::geometry_arena(weakref<device> p_device, uint32_t vertex_stride, uint32_t vertex_capacity, uint32_t index_capacity, VkIndexType index_type)
+    : m_device(std::move(p_device))
+    , m_vertex_stride(vertex_stride)
+    , m_index_size(index_type == VK_INDEX_TYPE_UINT16 ? 2 : 4)
+    , m_index_type(index_type)
+    , m_vertex_capacity(vertex_capacity)
+    , m_index_capacity(index_capacity)
+{
+    quix_assert(index_type == VK_INDEX_TYPE_UINT16 || index_type == VK_INDEX_TYPE_UINT32, "geometry arenas hold 16 or 32 bit indices");
+
+    m_vertex_block = create_virtual_block(vertex_capacity);
+    m_index_block = create_virtual_block(index_capacity);
+
+    m_vertex_buffer = create_buffer(VkDeviceSize { vertex_capacity } * m_vertex_stride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    m_index_buffer = create_buffer(VkDeviceSize { index_capacity } * m_index_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+}
+
+geometry_arena::~geometry_arena()
+{
+    // pending frees and retired buffers only guard gpu reads of the buffers, every buffer_handle already defers its
+    // destruction past all submitted work, so dropping them here needs no wait
+    m_pending_frees.clear();
+    m_retired.clear();
+
+    // virtual blocks must be empty before they are destroyed
+    vmaClearVirtualBlock(m_vertex_block);
+    vmaClearVirtualBlock(m_index_block);
+    vmaDestroyVirtualBlock(m_vertex_block);
+    vmaDestroyVirtualBlock(m_index_block);
+}
+
+NODISCARD std::optional<geometry_id> geometry_arena::allocate(const void* vertices, uint32_t vertex_count, const void* indices, uint32_t index_count, upload_batch* batch)
+{
+    quix_assert(vertex_count != 0 && index_count != 0, "cannot allocate empty geometry");
+    release_completed();
+
+    geometry_entry entry {};
+    entry.vertex_count = vertex_count;
+    entry.index_count = index_count;
+    entry.live = true;
+
+    if (!allocate_range(m_vertex_block, vertex_count, &entry.vertex_alloc, &entry.first_vertex)) {
+        return std::nullopt;
+    }
+    if (!allocate_range(m_index_block, index_count, &entry.index_alloc, &entry.first_index)) {
+        vmaVirtualFree(m_vertex_block, entry.vertex_alloc);
+        return std::nullopt;
+    }
+
+    batch->upload_buffer(m_vertex_buffer->get_buffer(), VkDeviceSize { entry.first_vertex } * m_vertex_stride, vertices, VkDeviceSize { vertex_count } * m_vertex_stride);
+    batch->upload_buffer(m_index_buffer->get_buffer(), VkDeviceSize { entry.first_index } * m_index_size, indices, VkDeviceSize { index_count } * m_index_size);
+
+    geometry_id id = 0;
+    if (!m_free_ids.empty()) {
+        id = m_free_ids.back();
+        m_free_ids.pop_back();
+        m_entries[id] = entry;
+    } else {
+        id = static_cast<geometry_id>(m_entries.size());
+        m_entries.push_back(entry);
+    }
+
+    return id;
+}
+
+void geometry_arena::free(geometry_id id, timeline_point last_use)
+{
+    quix_assert(id < m_entries.size() && m_entries[id].live, "geometry was already freed");
+
+    m_entries[id].live = false;
+    m_pending_frees.push_back(pending_free { last_use, id });
+}
+
+void geometry_arena::free(geometry_id id)
+{
+    free(id, m_device->get_last_submitted(queue_type::graphics));
+}
+
+timeline_point geometry_arena::compact()
+{
+    release_completed();
+
+    retired_buffers retired {};
+    // ranges of pending frees vanish with the old buffers, only those have to wait for the last use
+    for (const auto& pending : m_pending_frees) {
+        retired.points.push_back(pending.point);
+        m_entries[pending.id] = geometry_entry {};
+        m_free_ids.push_back(pending.id);
+    }
+    m_pending_frees.clear();
+
+    // packing in the current order keeps the copies of neighbouring meshes adjacent so they merge into fewer regions
+    std::vector<geometry_id> live {};
+    for (geometry_id id = 0; id < m_entries.size(); id++) {
+        if (m_entries[id].live) {
+            live.push_back(id);
+        }
+    }
+    std::sort(live.begin(), live.end(), [this](geometry_id a, geometry_id b) {
+        return m_entries[a].first_vertex < m_entries[b].first_vertex;
+    });
+
+    vmaClearVirtualBlock(m_vertex_block);
+    vmaClearVirtualBlock(m_index_block);
+
+    std::vector<VkBufferCopy> vertex_copies {};
+    std::vector<VkBufferCopy> index_copies {};
+    auto add_copy = [](std::vector<VkBufferCopy>* copies, VkDeviceSize src, VkDeviceSize dst, VkDeviceSize size) {
+        if (!copies->empty()) {
+            auto& last = copies->back();
+            if (last.srcOffset + last.size == src && last.dstOffset + last.size == dst) {
+                last.size += size;
+                return;
+            }
+        }
+        copies->push_back(VkBufferCopy { src, dst, size });
+    };
+
+    for (geometry_id id : live) {
+        auto& entry = m_entries[id];
+        const uint32_t old_first_vertex = entry.first_vertex;
+        const uint32_t old_first_index = entry.first_index;
+
+        // everything fitted before, so it fits when packed
+        const bool fits = allocate_range(m_vertex_block, entry.vertex_count, &entry.vertex_alloc, &entry.first_vertex)
+            && allocate_range(m_index_block, entry.index_count, &entry.index_alloc, &entry.first_index);
+        quix_assert(fits, "compacted geometry does not fit into the arena");
+
+        add_copy(&vertex_copies, VkDeviceSize { old_first_vertex } * m_vertex_stride, VkDeviceSize { entry.first_vertex } * m_vertex_stride,
+            VkDeviceSize { entry.vertex_count } * m_vertex_stride);
+        add_copy(&index_copies, VkDeviceSize { old_first_index } * m_index_size, VkDeviceSize { entry.first_index } * m_index_size,
+            VkDeviceSize { entry.index_count } * m_index_size);
+    }
+
+    auto vertex_buffer = create_buffer(VkDeviceSize { m_vertex_capacity } * m_vertex_stride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    auto index_buffer = create_buffer(VkDeviceSize { m_index_capacity } * m_index_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    command_buffer_lists buffers {};
+    VkCommandPool vk_pool = m_device->acquire_command_pool(queue_type::graphics, command_pool_usage::transient, &buffers);
+    command_pool pool { m_device, vk_pool, queue_type::graphics, command_pool_usage::transient, std::move(buffers) };
+    auto list = pool.create_command_list();
+
+    list->begin_record(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    // uploads into the old buffers end with barriers that make them visible to every later graphics submission
+    if (!live.empty()) {
+        list->copy_buffer_to_buffer(m_vertex_buffer->get_buffer(), vertex_buffer->get_buffer(), vertex_copies.data(), static_cast<uint32_t>(vertex_copies.size()));
+        list->copy_buffer_to_buffer(m_index_buffer->get_buffer(), index_buffer->get_buffer(), index_copies.data(), static_cast<uint32_t>(index_copies.size()));
+    }
+
+    std::array<VkBufferMemoryBarrier, 2> barriers {};
+    for (auto& barrier : barriers) {
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+    barriers[0].buffer = vertex_buffer->get_buffer();
+    barriers[0].dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[1].buffer = index_buffer->get_buffer();
+    barriers[1].dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        barriers.data(), static_cast<uint32_t>(barriers.size()), nullptr, 0);
+    list->end_record();
+
+    const timeline_point point = list->submit();
+
+    // recorded draws may still read the old buffers, they go once the copy and every pending free completed
+    retired.points.push_back(point);
+    retired.vertex_buffer = std::move(m_vertex_buffer);
+    retired.index_buffer = std::move(m_index_buffer);
+    m_retired.push_back(std::move(retired));
+
+    m_vertex_buffer = std::move(vertex_buffer);
+    m_index_buffer = std::move(index_buffer);
+
+    return point;
+}
+
+NODISCARD geometry_draw geometry_arena::get_draw(geometry_id id) const
+{
+    quix_assert(id < m_entries.size() && m_entries[id].live, "geometry was freed");
+
+    const auto& entry = m_entries[id];
+    geometry_draw draw {};
+    draw.index_count = entry.index_count;
+    draw.first_index = entry.first_index;
+    draw.vertex_offset = static_cast<int32_t>(entry.first_vertex);
+    draw.vertex_count = entry.vertex_count;
+    return draw;
+}
+
+void geometry_arena::bind(command_list* list) const
+{
+    list->bind_vertex_buffer(m_vertex_buffer->get_buffer());
+    list->bind_index_buffer(m_index_buffer->get_buffer(), 0, m_index_type);
+}
+
+NODISCARD uint32_t geometry_arena::get_free_vertices() const noexcept
+{
+    return get_free_count(m_vertex_block, m_vertex_capacity);
+}
+
+NODISCARD uint32_t geometry_arena::get_free_indices() const noexcept
+{
+    return get_free_count(m_index_block, m_index_capacity);
+}
+
+NODISCARD std::unique_ptr<buffer_handle> geometry_arena::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage) const
+{
+    auto buffer = std::make_unique<buffer_handle>(m_device);
+    buffer->create_gpu_buffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    return buffer;
+}
+
+void geometry_arena::release_completed()
+{
+    std::erase_if(m_pending_frees, [this](const pending_free& pending) {
+        if (!m_device->is_complete(pending.point)) {
+            return false;
+        }
+        release_entry(pending.id);
+        return true;
+    });
+
+    std::erase_if(m_retired, [this](const retired_buffers& retired) {
+        return std::all_of(retired.points.begin(), retired.points.end(), [this](timeline_point point) {
+            return m_device->is_complete(point);
+        });
+    });
+}
+
+void geometry_arena::release_entry(geometry_id id)
+{
+    auto& entry = m_entries[id];
+    vmaVirtualFree(m_vertex_block, entry.vertex_alloc);
+    vmaVirtualFree(m_index_block, entry.index_alloc);
+    entry = geometry_entry {};
+    m_free_ids.push_back(id);
+}
+
+} // namespace quix
+
+#endif // _QUIX_GEOMETRY_ARENA_CPP
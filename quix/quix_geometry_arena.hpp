@@ -0,0 +1,106 @@
+#ifndef _QUIX_GEOMETRY_ARENA_HPP
+#define _QUIX_GEOMETRY_ARENA_HPP
+
+#include "quix_resource.hpp"
+
+namespace quix {
+
+class device;
+class command_list;
+class upload_batch;
+
+using geometry_id = uint32_t;
+
+// what a draw of the mesh passes to vkCmdDrawIndexed, indices are relative to the first vertex of the mesh
+struct geometry_draw {
+    uint32_t index_count = 0;
+    uint32_t first_index = 0;
+    int32_t vertex_offset = 0;
+    uint32_t vertex_count = 0;
+};
+
+// one device local vertex buffer and one index buffer shared by many meshes, ranges are handed out by vma virtual blocks
+// so a scene binds both buffers once and only the offsets change per draw
+class geometry_arena {
+public:
+    geometry_arena(weakref<device> p_device, uint32_t vertex_stride, uint32_t vertex_capacity, uint32_t index_capacity,
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32);
+    // never waits, the buffers are destroyed through the device once every submission that may read them completed
+    ~geometry_arena();
+
+    geometry_arena(const geometry_arena&) = delete;
+    geometry_arena& operator=(const geometry_arena&) = delete;
+    geometry_arena(geometry_arena&&) = delete;
+    geometry_arena& operator=(geometry_arena&&) = delete;
+
+    // the data is queued on batch, empty when either buffer has no contiguous range left, compact() and try again
+    NODISCARD std::optional<geometry_id> allocate(const void* vertices, uint32_t vertex_count, const void* indices, uint32_t index_count, upload_batch* batch);
+    // the ranges are reused once last_use is complete, the overload without a point takes the last graphics submission
+    void free(geometry_id id, timeline_point last_use);
+    void free(geometry_id id);
+
+    // moves every live mesh to the front of new buffers with one copy per buffer on the graphics queue, draws have to be
+    // fetched again afterwards, batches uploading into the arena must be submitted first, graphics submissions made
+    // afterwards see the new buffers, the old ones are destroyed once the returned point is reached
+    timeline_point compact();
+
+    NODISCARD geometry_draw get_draw(geometry_id id) const;
+    void bind(command_list* list) const;
+
+    NODISCARD inline VkBuffer get_vertex_buffer() const noexcept { return m_vertex_buffer->get_buffer(); }
+    NODISCARD inline VkBuffer get_index_buffer() const noexcept { return m_index_buffer->get_buffer(); }
+    NODISCARD inline VkIndexType get_index_type() const noexcept { return m_index_type; }
+    // ranges of pending frees count as used until a later allocate or compact finds their last use complete, the
+    // largest contiguous range, not this total, is what allocate can still hand out
+    NODISCARD uint32_t get_free_vertices() const noexcept;
+    NODISCARD uint32_t get_free_indices() const noexcept;
+
+private:
+    struct geometry_entry {
+        VmaVirtualAllocation vertex_alloc = VK_NULL_HANDLE;
+        VmaVirtualAllocation index_alloc = VK_NULL_HANDLE;
+        uint32_t first_vertex = 0;
+        uint32_t vertex_count = 0;
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+        bool live = false;
+    };
+
+    struct pending_free {
+        timeline_point point {};
+        geometry_id id = 0;
+    };
+
+    // the compaction copy and any frees that were still pending, those may have been submitted to another queue
+    struct retired_buffers {
+        std::vector<timeline_point> points {};
+        std::unique_ptr<buffer_handle> vertex_buffer {};
+        std::unique_ptr<buffer_handle> index_buffer {};
+    };
+
+    NODISCARD std::unique_ptr<buffer_handle> create_buffer(VkDeviceSize size, VkBufferUsageFlags usage) const;
+    void release_completed();
+    void release_entry(geometry_id id);
+
+    weakref<device> m_device;
+    uint32_t m_vertex_stride;
+    uint32_t m_index_size;
+    VkIndexType m_index_type;
+
+    // block sizes are counted in vertices and indices so every offset is a valid vertexOffset or firstIndex as it is
+    VmaVirtualBlock m_vertex_block = VK_NULL_HANDLE;
+    VmaVirtualBlock m_index_block = VK_NULL_HANDLE;
+    std::unique_ptr<buffer_handle> m_vertex_buffer;
+    std::unique_ptr<buffer_handle> m_index_buffer;
+    uint32_t m_vertex_capacity;
+    uint32_t m_index_capacity;
+
+    std::vector<geometry_entry> m_entries {};
+    std::vector<geometry_id> m_free_ids {};
+    std::vector<pending_free> m_pending_frees {};
+    std::vector<retired_buffers> m_retired {};
+};
+
+} // namespace quix
+
+#endif // _QUIX_GEOMETRY_ARENA_HPP
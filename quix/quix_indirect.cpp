@@ -0,0 +1,206 @@
+#ifndef _QUIX_INDIRECT_CPP
+#define _QUIX_INDIRECT_CPP
+
+#include "quix_indirect.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+#include "quix_geometry_arena.hpp"
+
+namespace quix {
+
+namespace {
+
+    NODISCARD constexpr VkDeviceSize align_up(VkDeviceSize size, VkDeviceSize alignment) noexcept
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    void create_mapped_buffer(buffer_handle* handle, VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        VkBufferCreateInfo buffer_info {};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = size;
+        buffer_info.usage = usage;
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo alloc_info {};
+        alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+        alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+
+        handle->create_buffer(&buffer_info, &alloc_info);
+    }
+
+} // namespace
+
+indirect_draw_buffer::indirect_draw_buffer(weakref<device> p_device, int frames_in_flight, uint32_t max_draws, uint32_t draw_data_size, indirect_source source)
+    : m_device(std::move(p_device))
+    , m_commands(m_device)
+    , m_count(m_device)
+    , m_draw_data(m_device)
+    , m_frames_in_flight(frames_in_flight)
+    , m_max_draws(max_draws)
+    , m_draw_data_size(draw_data_size)
+    , m_source(source)
+{
+    quix_assert(frames_in_flight > 0 && max_draws > 0, "an indirect draw buffer needs at least one frame and one draw");
+
+    const device_features& features = m_device->get_enabled_features();
+    m_first_instance = features.core.features.drawIndirectFirstInstance == VK_TRUE;
+    m_multi_draw = features.core.features.multiDrawIndirect == VK_TRUE;
+    m_draw_count_buffer = features.vulkan12.drawIndirectCount == VK_TRUE;
+    quix_assert(source == indirect_source::cpu || m_draw_count_buffer, "gpu written indirect draws need the drawIndirectCount feature");
+    // the per draw fallback issues every draw on its own, gl_DrawID is 0 in all of them then
+    const bool draw_id = features.vulkan11.shaderDrawParameters == VK_TRUE && (source == indirect_source::gpu || m_multi_draw);
+    quix_assert(draw_data_size == 0 || m_first_instance || draw_id,
+        "draw data needs drawIndirectFirstInstance, or shaderDrawParameters with multiDrawIndirect or gpu written draws");
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->get_physical_device(), &properties);
+    // cpu buffers without multiDrawIndirect record one draw per call, every other path draws them all at once
+    quix_assert((source == indirect_source::cpu && !m_multi_draw) || max_draws <= properties.limits.maxDrawIndirectCount,
+        "max_draws is above the maxDrawIndirectCount limit");
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 4);
+
+    m_command_region = align_up(static_cast<VkDeviceSize>(max_draws) * sizeof(VkDrawIndexedIndirectCommand), alignment);
+    m_count_region = align_up(sizeof(uint32_t), alignment);
+    m_draw_data_region = align_up(static_cast<VkDeviceSize>(max_draws) * draw_data_size, alignment);
+
+    const VkDeviceSize frames = static_cast<VkDeviceSize>(frames_in_flight);
+    constexpr VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    if (source == indirect_source::gpu) {
+        m_commands.create_gpu_buffer(m_command_region * frames, usage);
+        m_count.create_gpu_buffer(m_count_region * frames, usage);
+        if (draw_data_size != 0) {
+            m_draw_data.create_gpu_buffer(m_draw_data_region * frames, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
+        return;
+    }
+
+    // written once per frame and read by the gpu, vma picks device local host visible memory where there is some
+    create_mapped_buffer(&m_commands, m_command_region * frames, usage);
+    create_mapped_buffer(&m_count, m_count_region * frames, usage);
+    if (draw_data_size != 0) {
+        create_mapped_buffer(&m_draw_data, m_draw_data_region * frames, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
+}
+
+void indirect_draw_buffer::begin_frame(int frame)
+{
+    quix_assert(frame >= 0 && frame < m_frames_in_flight, "frame is out of range");
+
+    m_frame = frame;
+    m_draw_count = 0;
+}
+
+uint32_t indirect_draw_buffer::add_draw(const VkDrawIndexedIndirectCommand& command, const void* draw_data)
+{
+    quix_assert(m_source == indirect_source::cpu, "draws of gpu written indirect buffers come from the gpu");
+    quix_assert(m_draw_count < m_max_draws, "indirect draw buffer is full");
+
+    const uint32_t index = m_draw_count++;
+
+    VkDrawIndexedIndirectCommand written = command;
+    if (m_first_instance) {
+        // more instances would run gl_InstanceIndex into the draw data of the following draws
+        quix_assert(command.instanceCount == 1, "firstInstance holds the draw index, draws need a single instance");
+        written.firstInstance = index;
+    }
+    auto* commands = static_cast<char*>(m_commands.get_mapped_data()) + get_command_offset();
+    std::memcpy(commands + index * sizeof(VkDrawIndexedIndirectCommand), &written, sizeof(VkDrawIndexedIndirectCommand));
+
+    if (draw_data != nullptr) {
+        quix_assert(m_draw_data_size != 0, "the indirect draw buffer has no draw data");
+        auto* data = static_cast<char*>(m_draw_data.get_mapped_data()) + get_draw_data_offset();
+        std::memcpy(data + static_cast<VkDeviceSize>(index) * m_draw_data_size, draw_data, m_draw_data_size);
+    }
+
+    return index;
+}
+
+uint32_t indirect_draw_buffer::add_draw(const geometry_draw& draw, uint32_t instance_count, const void* draw_data)
+{
+    VkDrawIndexedIndirectCommand command {};
+    command.indexCount = draw.index_count;
+    command.instanceCount = instance_count;
+    command.firstIndex = draw.first_index;
+    command.vertexOffset = draw.vertex_offset;
+    command.firstInstance = 0;
+    return add_draw(command, draw_data);
+}
+
+void indirect_draw_buffer::end_frame()
+{
+    if (m_source == indirect_source::gpu) {
+        return;
+    }
+
+    auto* count = static_cast<char*>(m_count.get_mapped_data()) + get_count_offset();
+    std::memcpy(count, &m_draw_count, sizeof(uint32_t));
+    m_count.flush(get_count_offset(), sizeof(uint32_t));
+
+    if (m_draw_count == 0) {
+        return;
+    }
+    m_commands.flush(get_command_offset(), static_cast<VkDeviceSize>(m_draw_count) * sizeof(VkDrawIndexedIndirectCommand));
+    if (m_draw_data_size != 0) {
+        m_draw_data.flush(get_draw_data_offset(), static_cast<VkDeviceSize>(m_draw_count) * m_draw_data_size);
+    }
+}
+
+void indirect_draw_buffer::clear_count(command_list* list)
+{
+    quix_assert(m_source == indirect_source::gpu, "the count of cpu written indirect buffers is written by end_frame");
+    list->fill_buffer(m_count.get_buffer(), get_count_offset(), sizeof(uint32_t), 0);
+}
+
+void indirect_draw_buffer::record(command_list* list)
+{
+    if (m_source == indirect_source::gpu) {
+        list->draw_indexed_indirect_count(m_commands.get_buffer(), get_command_offset(), m_count.get_buffer(), get_count_offset(), m_max_draws);
+        return;
+    }
+
+    if (m_draw_count == 0) {
+        return;
+    }
+    if (m_multi_draw) {
+        list->draw_indexed_indirect(m_commands.get_buffer(), get_command_offset(), m_draw_count);
+        return;
+    }
+    for (uint32_t i = 0; i < m_draw_count; i++) {
+        list->draw_indexed_indirect(m_commands.get_buffer(), get_command_offset() + i * sizeof(VkDrawIndexedIndirectCommand), 1);
+    }
+}
+
+NODISCARD VkDescriptorBufferInfo indirect_draw_buffer::get_command_info() const noexcept
+{
+    VkDescriptorBufferInfo info {};
+    info.buffer = m_commands.get_buffer();
+    info.offset = get_command_offset();
+    info.range = m_command_region;
+    return info;
+}
+
+NODISCARD VkDescriptorBufferInfo indirect_draw_buffer::get_count_info() const noexcept
+{
+    VkDescriptorBufferInfo info {};
+    info.buffer = m_count.get_buffer();
+    info.offset = get_count_offset();
+    info.range = sizeof(uint32_t);
+    return info;
+}
+
+NODISCARD VkDescriptorBufferInfo indirect_draw_buffer::get_draw_data_info() const noexcept
+{
+    VkDescriptorBufferInfo info {};
+    info.buffer = m_draw_data.get_buffer();
+    info.offset = get_draw_data_offset();
+    info.range = m_draw_data_region;
+    return info;
+}
+
+} // namespace quix
+
+#endif // _QUIX_INDIRECT_CPP
@@ -0,0 +1,95 @@
+#ifndef _QUIX_INDIRECT_HPP
+#define _QUIX_INDIRECT_HPP
+
+#include "quix_resource.hpp"
+
+namespace quix {
+
+class device;
+class command_list;
+struct geometry_draw;
+
+// who writes the draws of a frame, cpu buffers are mapped and filled with add_draw, gpu buffers live in device memory
+// and are filled by a compute pass, e.g. culling, that writes commands, the count and the draw data itself
+enum class indirect_source {
+    cpu,
+    gpu,
+};
+
+// an array of VkDrawIndexedIndirectCommand, a draw count and a storage buffer of per draw data for each frame in flight,
+// so thousands of draws go out with one indirect call, shaders find their draw data at gl_InstanceIndex when the device
+// has drawIndirectFirstInstance, add_draw then points firstInstance at the draw and gpu writers have to do the same,
+// otherwise at gl_DrawID, which needs shaderDrawParameters and, for cpu buffers, multiDrawIndirect since the fallback
+// issues one draw per call, construction with draw data asserts that one of the two is available
+class indirect_draw_buffer {
+public:
+    // draw_data_size is the size of the per draw struct in the storage buffer, 0 when there is none
+    indirect_draw_buffer(weakref<device> p_device, int frames_in_flight, uint32_t max_draws, uint32_t draw_data_size,
+        indirect_source source = indirect_source::cpu);
+
+    indirect_draw_buffer(const indirect_draw_buffer&) = delete;
+    indirect_draw_buffer& operator=(const indirect_draw_buffer&) = delete;
+    indirect_draw_buffer(indirect_draw_buffer&&) = delete;
+    indirect_draw_buffer& operator=(indirect_draw_buffer&&) = delete;
+
+    // the buffers of frame must no longer be in use, like frame_allocator::begin_frame
+    void begin_frame(int frame);
+    // cpu buffers only, returns the index of the draw in the command and draw data arrays, with
+    // drawIndirectFirstInstance the command's firstInstance is replaced by that index so it must have one instance
+    uint32_t add_draw(const VkDrawIndexedIndirectCommand& command, const void* draw_data = nullptr);
+    uint32_t add_draw(const geometry_draw& draw, uint32_t instance_count = 1, const void* draw_data = nullptr);
+    // writes the draw count and flushes what was written this frame, call before submitting the frame
+    void end_frame();
+
+    // gpu buffers only, zeroes the draw count of the current frame before the pass that fills it, the pass has to wait
+    // for the transfer
+    void clear_count(command_list* list);
+
+    // one vkCmdDrawIndexedIndirectCount for gpu buffers, cpu buffers know their count and use one multi draw, or a
+    // draw per command without multiDrawIndirect, vertex and index buffers have to be bound already
+    void record(command_list* list);
+
+    NODISCARD inline VkBuffer get_command_buffer() const noexcept { return m_commands.get_buffer(); }
+    NODISCARD inline VkBuffer get_count_buffer() const noexcept { return m_count.get_buffer(); }
+    NODISCARD inline VkBuffer get_draw_data_buffer() const noexcept { return m_draw_data.get_buffer(); }
+    // of the current frame
+    NODISCARD inline VkDeviceSize get_command_offset() const noexcept { return m_command_region * static_cast<VkDeviceSize>(m_frame); }
+    NODISCARD inline VkDeviceSize get_count_offset() const noexcept { return m_count_region * static_cast<VkDeviceSize>(m_frame); }
+    NODISCARD inline VkDeviceSize get_draw_data_offset() const noexcept { return m_draw_data_region * static_cast<VkDeviceSize>(m_frame); }
+
+    // the ranges of the current frame, for the descriptor sets of the shaders that read or write them
+    NODISCARD VkDescriptorBufferInfo get_command_info() const noexcept;
+    NODISCARD VkDescriptorBufferInfo get_count_info() const noexcept;
+    NODISCARD VkDescriptorBufferInfo get_draw_data_info() const noexcept;
+
+    NODISCARD inline uint32_t get_max_draws() const noexcept { return m_max_draws; }
+    // cpu buffers only
+    NODISCARD inline uint32_t get_draw_count() const noexcept { return m_draw_count; }
+
+private:
+    weakref<device> m_device;
+    buffer_handle m_commands;
+    buffer_handle m_count;
+    buffer_handle m_draw_data;
+
+    int m_frames_in_flight;
+    uint32_t m_max_draws;
+    uint32_t m_draw_data_size;
+    indirect_source m_source;
+
+    // per frame, aligned so every frame's range can be bound as a storage buffer
+    VkDeviceSize m_command_region = 0;
+    VkDeviceSize m_count_region = 0;
+    VkDeviceSize m_draw_data_region = 0;
+
+    bool m_first_instance = false;
+    bool m_multi_draw = false;
+    bool m_draw_count_buffer = false;
+
+    int m_frame = 0;
+    uint32_t m_draw_count = 0;
+};
+
+} // namespace quix
+
+#endif // _QUIX_INDIRECT_HPP
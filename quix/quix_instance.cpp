@@ -7,17 +7,26 @@
 #include "quix_common.hpp"
 #include "quix_descriptor.hpp"
 #include "quix_device.hpp"
+#include "quix_frame_allocator.hpp"
+#include "quix_geometry_arena.hpp"
+#include "quix_indirect.hpp"
+#include "quix_jobs.hpp"
 #include "quix_pipeline.hpp"
+#include "quix_query.hpp"
+#include "quix_registry.hpp"
+#include "quix_render_graph.hpp"
 #include "quix_render_target.hpp"
 #include "quix_resource.hpp"
 #include "quix_swapchain.hpp"
+#include "quix_texture_loader.hpp"
+#include "quix_upload.hpp"
 #include "quix_window.hpp"
 
 namespace quix {
 
 consteval std::size_t get_allocation_size()
 {
-    return sizeof(window) + sizeof(device) + sizeof(swapchain) + sizeof(graphics::pipeline_manager) + sizeof(descriptor::allocator) + sizeof(descriptor::layout_cache);
+    return sizeof(window) + sizeof(device) + sizeof(swapchain) + sizeof(graphics::pipeline_manager) + sizeof(descriptor::allocator) + sizeof(descriptor::layout_cache) + sizeof(job_system) + sizeof(upload_manager);
 }
 
 instance::instance(const char* app_name,
@@ -35,17 +44,42 @@ instance::instance(const char* app_name,
     , m_pipeline_manager(nullptr)
     , m_descriptor_allocator(nullptr)
     , m_descriptor_layout_cache(nullptr)
+    , m_job_system(nullptr)
+    , m_upload_manager(nullptr)
 {
     static_assert(get_allocation_size()
             <= m_buffer_size,
         "instance buffer size is too small");
 }
 
+instance::instance(const char* app_name,
+    uint32_t app_version)
+    : m_window(nullptr)
+    , m_device(allocate_unique<device>(&m_allocator,
+          make_weakref<window>(m_window),
+          app_name,
+          app_version,
+          "quix",
+          VK_MAKE_VERSION(1, 0, 0)))
+    , m_swapchain(nullptr)
+    , m_pipeline_manager(nullptr)
+    , m_descriptor_allocator(nullptr)
+    , m_descriptor_layout_cache(nullptr)
+    , m_job_system(nullptr)
+    , m_upload_manager(nullptr)
+{
+}
+
 instance::~instance() = default;
 
 void instance::create_device(std::vector<const char*>&& requested_extensions, VkPhysicalDeviceFeatures requested_features)
 {
-    m_device->init(std::move(requested_extensions), requested_features);
+    create_device(std::move(requested_extensions), device_features { requested_features }, device_features {});
+}
+
+void instance::create_device(std::vector<const char*>&& requested_extensions, const device_features& required_features, const device_features& preferred_features)
+{
+    m_device->init(std::move(requested_extensions), required_features, preferred_features);
 
     m_descriptor_allocator = allocate_unique<descriptor::allocator>(&m_allocator, m_device->get_logical_device());
     m_descriptor_layout_cache = allocate_unique<descriptor::layout_cache>(&m_allocator, m_device->get_logical_device());
@@ -53,20 +87,84 @@ void instance::create_device(std::vector<const char*>&& requested_extensions, Vk
 
 void instance::create_swapchain(const int32_t frames_in_flight, const VkPresentModeKHR present_mode, const bool depth_buffer)
 {
+    quix_assert(!is_headless(), "cannot create a swapchain on a headless instance");
     m_swapchain = allocate_unique<swapchain>(&m_allocator, make_weakref<instance>(this), make_weakref<window>(m_window), make_weakref<device>(m_device), frames_in_flight, present_mode, depth_buffer);
 }
 
 void instance::create_pipeline_manager()
 {
     // TODO : make pipeline manager threadsafe (probably?)
-    m_pipeline_manager = allocate_unique<graphics::pipeline_manager>(&m_allocator, make_weakref<device>(m_device));
+    m_pipeline_manager = allocate_unique<graphics::pipeline_manager>(&m_allocator, make_weakref<device>(m_device), m_pipeline_cache_path);
+    if (m_upload_manager.get() != nullptr) {
+        m_upload_manager->get_mip_generator()->set_pipeline_cache(m_pipeline_manager->get_pipeline_cache());
+    }
+}
+
+void instance::create_job_system()
+{
+    m_job_system = allocate_unique<job_system>(&m_allocator, 0u);
+}
+
+void instance::create_upload_manager()
+{
+    // the pipeline manager is not created here, its cache path may still be set, it hands the cache over once it exists
+    const VkPipelineCache pipeline_cache = m_pipeline_manager.get() != nullptr ? m_pipeline_manager->get_pipeline_cache() : VK_NULL_HANDLE;
+    m_upload_manager = allocate_unique<upload_manager>(&m_allocator, make_weakref<device>(m_device), upload_manager::default_ring_size, pipeline_cache);
 }
 
-NODISCARD command_pool instance::get_command_pool()
+NODISCARD weakref<upload_manager> instance::get_upload_manager()
 {
+    if (m_upload_manager.get() == nullptr) {
+        create_upload_manager();
+    }
+    return make_weakref<upload_manager>(m_upload_manager);
+}
+
+NODISCARD upload_batch instance::create_upload_batch()
+{
+    return upload_batch {
+        get_upload_manager()
+    };
+}
+
+NODISCARD texture_loader instance::create_texture_loader(uint32_t max_in_flight)
+{
+    return texture_loader {
+        get_job_system(),
+        get_upload_manager(),
+        max_in_flight
+    };
+}
+
+NODISCARD weakref<job_system> instance::get_job_system()
+{
+    if (m_job_system.get() == nullptr) {
+        create_job_system();
+    }
+    return make_weakref<job_system>(m_job_system);
+}
+
+NODISCARD command_pool instance::get_command_pool(queue_type type, command_pool_usage usage)
+{
+    command_buffer_lists buffers {};
+    VkCommandPool pool = m_device->acquire_command_pool(type, usage, &buffers);
+
     return command_pool {
         make_weakref<device>(m_device),
-        m_device->get_command_pool()
+        pool,
+        type,
+        usage,
+        std::move(buffers)
+    };
+}
+
+NODISCARD secondary_pass instance::create_secondary_pass(uint32_t list_count, queue_type type)
+{
+    return secondary_pass {
+        make_weakref<device>(m_device),
+        get_job_system(),
+        list_count,
+        type
     };
 }
 
@@ -157,6 +255,25 @@ NODISCARD render_target instance::create_render_target(const VkRenderPassCreateI
     };
 }
 
+NODISCARD render_target instance::create_dynamic_render_target() noexcept
+{
+    return render_target {
+        make_weakref<window>(m_window),
+        make_weakref<device>(m_device),
+        make_weakref<swapchain>(m_swapchain)
+    };
+}
+
+NODISCARD render_target instance::create_offscreen_render_target(const VkRenderPassCreateInfo&& render_pass_create_info, std::vector<VkImageView>&& attachments, VkExtent2D extent) noexcept
+{
+    return render_target {
+        make_weakref<device>(m_device),
+        &render_pass_create_info,
+        std::move(attachments),
+        extent
+    };
+}
+
 NODISCARD sync instance::create_sync_objects() noexcept
 {
     return sync {
@@ -165,6 +282,62 @@ NODISCARD sync instance::create_sync_objects() noexcept
     };
 }
 
+NODISCARD query_profiler instance::create_query_profiler(int frames_in_flight, uint32_t max_scopes, bool pipeline_statistics)
+{
+    return query_profiler {
+        make_weakref<device>(m_device),
+        frames_in_flight,
+        max_scopes,
+        pipeline_statistics
+    };
+}
+
+NODISCARD frame_allocator instance::create_frame_allocator(int frames_in_flight, VkDeviceSize frame_size, VkBufferUsageFlags usage)
+{
+    return frame_allocator {
+        make_weakref<device>(m_device),
+        frames_in_flight,
+        frame_size,
+        usage
+    };
+}
+
+NODISCARD geometry_arena instance::create_geometry_arena(uint32_t vertex_stride, uint32_t vertex_capacity, uint32_t index_capacity, VkIndexType index_type)
+{
+    return geometry_arena {
+        make_weakref<device>(m_device),
+        vertex_stride,
+        vertex_capacity,
+        index_capacity,
+        index_type
+    };
+}
+
+NODISCARD indirect_draw_buffer instance::create_indirect_draw_buffer(int frames_in_flight, uint32_t max_draws, uint32_t draw_data_size, indirect_source source)
+{
+    return indirect_draw_buffer {
+        make_weakref<device>(m_device),
+        frames_in_flight,
+        max_draws,
+        draw_data_size,
+        source
+    };
+}
+
+NODISCARD resource_registry instance::create_resource_registry()
+{
+    return resource_registry {
+        make_weakref<device>(m_device)
+    };
+}
+
+NODISCARD render_graph instance::create_render_graph()
+{
+    return render_graph {
+        make_weakref<device>(m_device)
+    };
+}
+
 NODISCARD buffer_handle instance::create_buffer_handle() const noexcept
 {
     return buffer_handle {
@@ -184,6 +357,16 @@ void instance::wait_idle()
     m_device->wait_idle();
 }
 
+void instance::wait(timeline_point point)
+{
+    m_device->wait(point);
+}
+
+NODISCARD bool instance::is_complete(timeline_point point)
+{
+    return m_device->is_complete(point);
+}
+
 NODISCARD weakref<window>
 instance::get_window() const noexcept
 {
@@ -201,6 +384,12 @@ NODISCARD VkSurfaceFormatKHR instance::get_surface_format() const noexcept
     return m_swapchain->get_surface_format();
 }
 
+void instance::set_pipeline_cache_path(const char* path)
+{
+    quix_assert(m_pipeline_manager.get() == nullptr, "pipeline cache path has to be set before the pipeline manager is created");
+    m_pipeline_cache_path = path;
+}
+
 NODISCARD weakref<graphics::pipeline_manager> instance::get_pipeline_manager() noexcept
 {
     if (m_pipeline_manager.get() == nullptr) {
@@ -6,6 +6,7 @@ namespace quix {
 
 class window;
 class device;
+struct device_features;
 class swapchain;
 class render_target;
 
@@ -21,13 +22,27 @@ namespace descriptor {
 }
 
 class sync;
+class job_system;
 class command_pool;
+class secondary_pass;
+class query_profiler;
+class frame_allocator;
+class geometry_arena;
+class indirect_draw_buffer;
+enum class indirect_source;
+class render_graph;
+class resource_registry;
+class upload_manager;
+class upload_batch;
+class texture_loader;
 
 class buffer_handle;
 
 class instance {
 public:
     instance(const char* app_name, uint32_t app_version, int width, int height);
+    // headless instance, no window or surface is ever created so swapchains and render targets that present are unavailable
+    instance(const char* app_name, uint32_t app_version);
     ~instance();
 
     instance(const instance&) = delete;
@@ -36,24 +51,59 @@ public:
     instance& operator=(instance&&) = delete;
 
     void create_device(std::vector<const char*>&& requested_extensions, VkPhysicalDeviceFeatures requested_features);
+    void create_device(std::vector<const char*>&& requested_extensions, const device_features& required_features, const device_features& preferred_features);
     void create_swapchain(const int32_t frames_in_flight, const VkPresentModeKHR present_mode, const bool depth_buffer);
 
     NODISCARD render_target create_single_pass_render_target() noexcept;
     NODISCARD render_target create_single_pass_depth_render_target() noexcept;
     NODISCARD render_target create_render_target(const VkRenderPassCreateInfo&& render_pass_create_info) noexcept;
+    // renders into the swapchain with dynamic rendering, pipelines built for it only depend on its formats
+    NODISCARD render_target create_dynamic_render_target() noexcept;
+    // renders into user provided image views instead of the swapchain, works on headless instances
+    NODISCARD render_target create_offscreen_render_target(const VkRenderPassCreateInfo&& render_pass_create_info, std::vector<VkImageView>&& attachments, VkExtent2D extent) noexcept;
     NODISCARD sync create_sync_objects() noexcept;
+    // frames_in_flight should match the sync objects the profiled frames are submitted with
+    NODISCARD query_profiler create_query_profiler(int frames_in_flight, uint32_t max_scopes = 32, bool pipeline_statistics = false);
+    // per frame constants sub-allocated from one buffer, frame_size is the budget of every frame in flight
+    NODISCARD frame_allocator create_frame_allocator(int frames_in_flight, VkDeviceSize frame_size, VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    // capacities are counted in vertices and indices
+    NODISCARD geometry_arena create_geometry_arena(uint32_t vertex_stride, uint32_t vertex_capacity, uint32_t index_capacity, VkIndexType index_type = VK_INDEX_TYPE_UINT32);
+    // draw_data_size is the size of the per draw struct, 0 when the draws have no data of their own
+    NODISCARD indirect_draw_buffer create_indirect_draw_buffer(int frames_in_flight, uint32_t max_draws, uint32_t draw_data_size, indirect_source source);
+    // buffers and images behind generational handles, an alternative to owning buffer_handle and image_handle objects
+    NODISCARD resource_registry create_resource_registry();
+    // passes with declared reads and writes, barriers and transient memory are derived when it is compiled
+    NODISCARD render_graph create_render_graph();
     
     NODISCARD buffer_handle create_buffer_handle() const noexcept;
     NODISCARD image_handle create_image_handle() const noexcept;
 
     void wait_idle();
+    // blocks until the queue that produced the point has executed past it
+    void wait(timeline_point point);
+    NODISCARD bool is_complete(timeline_point point);
+
+    NODISCARD bool is_headless() const noexcept { return m_window.get() == nullptr; }
 
     NODISCARD weakref<window> get_window() const noexcept;
     NODISCARD VkDevice get_logical_device() const noexcept;
     NODISCARD VkSurfaceFormatKHR get_surface_format() const noexcept;
 
     NODISCARD weakref<graphics::pipeline_manager> get_pipeline_manager() noexcept;
-    NODISCARD command_pool get_command_pool();
+    // workers are started on first use
+    NODISCARD weakref<job_system> get_job_system();
+    // created on first use, staged buffers and file images made through the instance go out through it right away
+    NODISCARD weakref<upload_manager> get_upload_manager();
+    // uploads queued on a batch go out in one submission when it is submitted or dropped
+    NODISCARD upload_batch create_upload_batch();
+    // reads and decodes on the job system and stages through the upload manager
+    NODISCARD texture_loader create_texture_loader(uint32_t max_in_flight = 64);
+    // where the pipeline cache is loaded from and saved to, must be set before the pipeline manager is first used
+    void set_pipeline_cache_path(const char* path);
+    // transient pools fit one shot uploads and per frame recording, a pool dropped at the end of a frame is
+    // reset wholesale and handed out again once that frame's submissions have completed
+    NODISCARD command_pool get_command_pool(queue_type type = queue_type::graphics, command_pool_usage usage = command_pool_usage::persistent);
+    NODISCARD secondary_pass create_secondary_pass(uint32_t list_count, queue_type type = queue_type::graphics);
 
     NODISCARD descriptor::allocator_pool get_descriptor_allocator_pool() const noexcept;
     NODISCARD descriptor::builder get_descriptor_builder(descriptor::allocator_pool* allocator_pool) const noexcept;
@@ -65,8 +115,10 @@ private:
 
     NODISCARD weakref<device> get_device() const noexcept;
     void create_pipeline_manager();
+    void create_job_system();
+    void create_upload_manager();
 
-    static constexpr std::size_t m_buffer_size = 2048;
+    static constexpr std::size_t m_buffer_size = 8192;
     std::array<char, m_buffer_size> m_buffer{};
     std::pmr::monotonic_buffer_resource m_allocator{m_buffer.data(), m_buffer_size};
 
@@ -76,6 +128,10 @@ private:
     allocated_unique_ptr<graphics::pipeline_manager> m_pipeline_manager;
     allocated_unique_ptr<descriptor::allocator> m_descriptor_allocator;
     allocated_unique_ptr<descriptor::layout_cache> m_descriptor_layout_cache;
+    allocated_unique_ptr<job_system> m_job_system;
+    allocated_unique_ptr<upload_manager> m_upload_manager;
+
+    std::string m_pipeline_cache_path {};
 };
 
 } // namespace quix
@@ -0,0 +1,234 @@
+#ifndef _QUIX_JOBS_CPP
+#define _QUIX_JOBS_CPP
+
+#include "quix_jobs.hpp"
+
+namespace quix {
+
+namespace {
+
+    // lets a worker find its own queue, the owner check keeps several job systems apart
+    thread_local const job_system* current_owner = nullptr;
+    thread_local uint32_t current_queue_index = 0;
+
+} // namespace
+
+job_counter::~job_counter()
+{
+    std::lock_guard<std::mutex> lock(m_continuation_mutex);
+}
+
+job_system::job_system(uint32_t worker_count)
+{
+    if (worker_count == 0) {
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    m_queues.reserve(worker_count + 1);
+    for (uint32_t i = 0; i < worker_count + 1; i++) {
+        m_queues.push_back(std::make_unique<worker_queue>());
+    }
+
+    m_workers.reserve(worker_count);
+    for (uint32_t i = 0; i < worker_count; i++) {
+        m_workers.emplace_back(&job_system::worker_loop, this, i + 1);
+    }
+
+    spdlog::info("job system started with {} workers", worker_count);
+}
+
+job_system::~job_system()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_running.store(false, std::memory_order_release);
+    }
+    m_wake.notify_all();
+
+    // workers drain every queue before they exit
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void job_system::schedule(job&& work, job_counter* counter)
+{
+    if (counter != nullptr) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    push(queued_job { std::move(work), counter });
+}
+
+void job_system::schedule_after(job_counter* dependency, job&& work, job_counter* counter)
+{
+    if (counter != nullptr) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dependency->m_continuation_mutex);
+        if (!dependency->is_done()) {
+            dependency->m_continuations.emplace_back(std::move(work), counter);
+            return;
+        }
+    }
+
+    push(queued_job { std::move(work), counter });
+}
+
+void job_system::parallel_for(uint32_t count, uint32_t batch_size, const std::function<void(uint32_t)>& body, job_counter* counter)
+{
+    batch_size = std::max(batch_size, 1u);
+
+    // body is captured by reference, so it has to outlive the counter like every other job argument
+    for (uint32_t begin = 0; begin < count; begin += batch_size) {
+        const uint32_t end = std::min(begin + batch_size, count);
+        auto batch = [&body, begin, end]() {
+            for (uint32_t i = begin; i < end; i++) {
+                body(i);
+            }
+        };
+        schedule(std::move(batch), counter);
+    }
+}
+
+void job_system::wait(job_counter* counter)
+{
+    const uint32_t queue_index = get_current_queue();
+    while (!counter->is_done()) {
+        if (try_run_one(queue_index)) {
+            continue;
+        }
+
+        // the remaining jobs run on other threads, sleep until one of them finishes a counter or more work shows up
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_waiter_wake.wait(lock, [this, counter]() {
+            return counter->is_done() || m_queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+NODISCARD uint32_t job_system::get_current_queue() const noexcept
+{
+    return current_owner == this ? current_queue_index : 0;
+}
+
+void job_system::push(queued_job&& entry)
+{
+    // counted before the job becomes visible, a thief decrementing first would wrap the count around
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    auto& queue = *m_queues[get_current_queue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(entry));
+    }
+
+    // taking the lock orders the increment before a worker's predicate check, so the wake up cannot be lost
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    }
+    m_wake.notify_one();
+    // workers blocked in wait may be the only ones left to run it
+    m_waiter_wake.notify_all();
+}
+
+NODISCARD bool job_system::try_run_one(uint32_t queue_index)
+{
+    queued_job entry {};
+    bool found = false;
+
+    // own queue from the back while the job's data is still warm
+    {
+        auto& queue = *m_queues[queue_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            entry = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // steal the oldest job of another queue
+    for (std::size_t offset = 1; !found && offset < m_queues.size(); offset++) {
+        auto& queue = *m_queues[(queue_index + offset) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            entry = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    run(entry);
+    return true;
+}
+
+void job_system::run(queued_job& entry)
+{
+    entry.work();
+
+    job_counter* counter = entry.counter;
+    if (counter == nullptr) {
+        return;
+    }
+
+    uint32_t pending = counter->m_pending.load(std::memory_order_acquire);
+    while (pending > 1) {
+        if (counter->m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return;
+        }
+    }
+
+    // the last decrement happens under the lock, a waiter may destroy the counter as soon as it reads zero
+    // and the destructor takes the same lock, so the counter is never touched after it is released
+    std::vector<std::pair<job, job_counter*>> continuations {};
+    {
+        std::lock_guard<std::mutex> lock(counter->m_continuation_mutex);
+        if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        continuations.swap(counter->m_continuations);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    }
+    m_waiter_wake.notify_all();
+
+    for (auto& [work, continuation_counter] : continuations) {
+        push(queued_job { std::move(work), continuation_counter });
+    }
+}
+
+void job_system::worker_loop(uint32_t index)
+{
+    current_owner = this;
+    current_queue_index = index;
+
+    while (true) {
+        if (try_run_one(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake.wait(lock, [this]() {
+            return !m_running.load(std::memory_order_acquire) || m_queued.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!m_running.load(std::memory_order_acquire) && m_queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace quix
+
+#endif // _QUIX_JOBS_CPP
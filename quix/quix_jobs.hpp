@@ -0,0 +1,90 @@
+#ifndef _QUIX_JOBS_HPP
+#define _QUIX_JOBS_HPP
+
+namespace quix {
+
+class job_system;
+
+using job = std::function<void()>;
+
+// counts the jobs scheduled with it that have not finished yet, jobs scheduled after it run once it reaches zero,
+// a counter must outlive every job scheduled with or after it
+class job_counter {
+    friend class job_system;
+
+public:
+    job_counter() = default;
+    ~job_counter();
+
+    job_counter(const job_counter&) = delete;
+    job_counter& operator=(const job_counter&) = delete;
+    job_counter(job_counter&&) = delete;
+    job_counter& operator=(job_counter&&) = delete;
+
+    NODISCARD inline bool is_done() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    std::atomic<uint32_t> m_pending { 0 };
+
+    std::mutex m_continuation_mutex;
+    std::vector<std::pair<job, job_counter*>> m_continuations {};
+};
+
+// every worker owns a deque it pushes to and pops from the back of, idle workers steal from the front of the others,
+// threads that are not workers share one extra queue
+class job_system {
+public:
+    // 0 uses one worker per hardware thread minus the calling thread
+    explicit job_system(uint32_t worker_count = 0);
+    ~job_system();
+
+    job_system(const job_system&) = delete;
+    job_system& operator=(const job_system&) = delete;
+    job_system(job_system&&) = delete;
+    job_system& operator=(job_system&&) = delete;
+
+    // counter may be null, otherwise it is incremented now and decremented once the job has run
+    void schedule(job&& work, job_counter* counter = nullptr);
+    // runs work once dependency reaches zero, counter is incremented right away so it can be waited on immediately
+    void schedule_after(job_counter* dependency, job&& work, job_counter* counter = nullptr);
+
+    // splits [0, count) into batches of batch_size, body is called once per index
+    void parallel_for(uint32_t count, uint32_t batch_size, const std::function<void(uint32_t)>& body, job_counter* counter);
+
+    // the calling thread runs queued jobs until the counter reaches zero, it only blocks once there is nothing to run
+    void wait(job_counter* counter);
+
+    NODISCARD inline uint32_t get_worker_count() const noexcept { return static_cast<uint32_t>(m_workers.size()); }
+
+private:
+    struct queued_job {
+        job work;
+        job_counter* counter = nullptr;
+    };
+
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<queued_job> jobs {};
+    };
+
+    NODISCARD uint32_t get_current_queue() const noexcept;
+    void push(queued_job&& entry);
+    NODISCARD bool try_run_one(uint32_t queue_index);
+    void run(queued_job& entry);
+    void worker_loop(uint32_t index);
+
+    // index 0 is shared by every thread that is not a worker
+    std::vector<std::unique_ptr<worker_queue>> m_queues {};
+    std::vector<std::thread> m_workers {};
+
+    std::atomic<bool> m_running { true };
+    std::atomic<uint32_t> m_queued { 0 };
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+    // threads inside wait sleep on this one, finished counters and new jobs wake all of them
+    std::condition_variable m_waiter_wake;
+};
+
+} // namespace quix
+
+#endif // _QUIX_JOBS_HPP
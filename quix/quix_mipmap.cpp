@@ -0,0 +1,421 @@
+#ifndef _QUIX_MIPMAP_CPP
+#define _QUIX_MIPMAP_CPP
+
+#include "quix_mipmap.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+#include "quix_resource.hpp"
+#include "quix_shader.hpp"
+
+namespace quix {
+
+namespace {
+
+    constexpr uint32_t downsample_group_size = 8;
+
+    // texelFetch ignores the sampler, so formats without linear filtering can be read as well,
+    // odd sizes clamp the second tap onto the last texel
+    constexpr const char* downsample_source = R"(#version 450
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(set = 0, binding = 0) uniform sampler2DArray src_level;
+layout(set = 0, binding = 1) writeonly uniform image2DArray dst_level;
+
+void main()
+{
+    const ivec3 texel = ivec3(gl_GlobalInvocationID);
+    const ivec3 dst_size = imageSize(dst_level);
+    if (texel.x >= dst_size.x || texel.y >= dst_size.y) {
+        return;
+    }
+
+    const ivec2 src_max = textureSize(src_level, 0).xy - 1;
+    const ivec2 first = min(texel.xy * 2, src_max);
+    const ivec2 second = min(texel.xy * 2 + 1, src_max);
+
+    const vec4 sum = texelFetch(src_level, ivec3(first.x, first.y, texel.z), 0)
+        + texelFetch(src_level, ivec3(second.x, first.y, texel.z), 0)
+        + texelFetch(src_level, ivec3(first.x, second.y, texel.z), 0)
+        + texelFetch(src_level, ivec3(second.x, second.y, texel.z), 0);
+
+    imageStore(dst_level, texel, sum * 0.25);
+}
+)";
+
+} // namespace
+
+NODISCARD uint32_t get_full_mip_count(VkExtent3D extent) noexcept
+{
+    uint32_t size = std::max(extent.width, extent.height);
+    uint32_t levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+mip_generator::mip_generator(weakref<device> p_device, VkPipelineCache pipeline_cache)
+    : m_device(std::move(p_device))
+    , m_pipeline_cache(pipeline_cache)
+{
+}
+
+mip_generator::~mip_generator()
+{
+    VkDevice logical_device = m_device->get_logical_device();
+
+    for (const auto& resources : m_in_flight) {
+        if (resources.submitted) {
+            m_device->wait(resources.point);
+        }
+        for (VkImageView view : resources.views) {
+            vkDestroyImageView(logical_device, view, nullptr);
+        }
+        vkDestroyDescriptorPool(logical_device, resources.descriptor_pool, nullptr);
+    }
+
+    if (m_pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(logical_device, m_pipeline, nullptr);
+        vkDestroyPipelineLayout(logical_device, m_pipeline_layout, nullptr);
+        vkDestroyDescriptorSetLayout(logical_device, m_set_layout, nullptr);
+        vkDestroySampler(logical_device, m_sampler, nullptr);
+    }
+}
+
+NODISCARD mip_method mip_generator::get_method(VkFormat format) const
+{
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_device->get_physical_device(), format, &properties);
+    const VkFormatFeatureFlags features = properties.optimalTilingFeatures;
+
+    constexpr VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if ((features & blit_features) == blit_features) {
+        return mip_method::blit;
+    }
+
+    // the downsample shader stores without a format qualifier so one shader serves every format
+    constexpr VkFormatFeatureFlags compute_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    if ((features & compute_features) == compute_features
+        && m_device->get_enabled_features().core.features.shaderStorageImageWriteWithoutFormat == VK_TRUE) {
+        return mip_method::compute;
+    }
+
+    return mip_method::none;
+}
+
+void mip_generator::record(command_list* list, const mip_image& image, uint64_t owner)
+{
+    quix_assert(image.extent.depth == 1, "mip generation only supports 2d images");
+
+    if (image.mip_levels <= 1) {
+        return;
+    }
+
+    switch (get_method(image.format)) {
+    case mip_method::blit:
+        record_blit(list, image);
+        break;
+    case mip_method::compute:
+        record_compute(list, image, owner);
+        break;
+    case mip_method::none:
+        quix_error("format supports neither blit nor compute mip generation");
+    }
+}
+
+void mip_generator::set_pipeline_cache(VkPipelineCache pipeline_cache)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pipeline_cache = pipeline_cache;
+}
+
+void mip_generator::track_submit(uint64_t owner, timeline_point point)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& resources : m_in_flight) {
+        if (resources.owner == owner && !resources.submitted) {
+            resources.point = point;
+            resources.submitted = true;
+        }
+    }
+}
+
+void mip_generator::record_blit(command_list* list, const mip_image& image)
+{
+    const uint32_t levels = image.mip_levels;
+    auto width = static_cast<int32_t>(image.extent.width);
+    auto height = static_cast<int32_t>(image.extent.height);
+
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = image.image;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = image.array_layers;
+
+    // each level is read once it is complete and handed to the shaders right after its blit
+    for (uint32_t level = 1; level < levels; level++) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, nullptr, 0, &barrier, 1);
+
+        const int32_t next_width = std::max(width / 2, 1);
+        const int32_t next_height = std::max(height / 2, 1);
+
+        VkImageBlit blit {};
+        blit.srcOffsets[1] = { width, height, 1 };
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = image.array_layers;
+        blit.dstOffsets[1] = { next_width, next_height, 1 };
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = image.array_layers;
+
+        vkCmdBlitImage(list->get_cmd_buffer(),
+            image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit, VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, nullptr, 0, &barrier, 1);
+
+        width = next_width;
+        height = next_height;
+    }
+
+    // the last level is only ever written
+    barrier.subresourceRange.baseMipLevel = levels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, nullptr, 0, &barrier, 1);
+}
+
+void mip_generator::record_compute(command_list* list, const mip_image& image, uint64_t owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    release_completed();
+    if (m_pipeline == VK_NULL_HANDLE) {
+        create_compute_pipeline();
+    }
+
+    VkDevice logical_device = m_device->get_logical_device();
+    const uint32_t levels = image.mip_levels;
+    const uint32_t layers = image.array_layers;
+    const uint32_t set_count = levels - 1;
+
+    compute_resources resources {};
+    resources.owner = owner;
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes {};
+    pool_sizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count };
+    pool_sizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, set_count };
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = set_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VK_CHECK(vkCreateDescriptorPool(logical_device, &pool_info, nullptr, &resources.descriptor_pool), "failed to create mip descriptor pool");
+
+    resources.views.resize(levels);
+    for (uint32_t level = 0; level < levels; level++) {
+        VkImageViewCreateInfo view_info {};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = image.image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        view_info.format = image.format;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.baseMipLevel = level;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = layers;
+
+        VK_CHECK(vkCreateImageView(logical_device, &view_info, nullptr, &resources.views[level]), "failed to create mip level view");
+    }
+
+    std::vector<VkDescriptorSetLayout> set_layouts(set_count, m_set_layout);
+    std::vector<VkDescriptorSet> sets(set_count);
+
+    VkDescriptorSetAllocateInfo set_info {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = resources.descriptor_pool;
+    set_info.descriptorSetCount = set_count;
+    set_info.pSetLayouts = set_layouts.data();
+
+    VK_CHECK(vkAllocateDescriptorSets(logical_device, &set_info, sets.data()), "failed to allocate mip descriptor sets");
+
+    for (uint32_t level = 1; level < levels; level++) {
+        VkDescriptorImageInfo src_info {};
+        src_info.sampler = m_sampler;
+        src_info.imageView = resources.views[level - 1];
+        src_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkDescriptorImageInfo dst_info {};
+        dst_info.imageView = resources.views[level];
+        dst_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes {};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = sets[level - 1];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &src_info;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = sets[level - 1];
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &dst_info;
+
+        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // the first level becomes readable and every other level writable in one go, their old contents are discarded
+    std::array<VkImageMemoryBarrier, 2> barriers {};
+    for (auto& barrier : barriers) {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image.image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layers;
+    }
+    barriers[0].subresourceRange.baseMipLevel = 0;
+    barriers[0].subresourceRange.levelCount = 1;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[1].subresourceRange.baseMipLevel = 1;
+    barriers[1].subresourceRange.levelCount = levels - 1;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].srcAccessMask = 0;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, nullptr, 0, barriers.data(), static_cast<uint32_t>(barriers.size()));
+
+    vkCmdBindPipeline(list->get_cmd_buffer(), VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+    VkImageMemoryBarrier& level_barrier = barriers[1];
+    level_barrier.subresourceRange.levelCount = 1;
+    level_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    level_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    level_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    uint32_t width = image.extent.width;
+    uint32_t height = image.extent.height;
+    for (uint32_t level = 1; level < levels; level++) {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+
+        vkCmdBindDescriptorSets(list->get_cmd_buffer(), VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &sets[level - 1], 0, nullptr);
+        vkCmdDispatch(list->get_cmd_buffer(),
+            (width + downsample_group_size - 1) / downsample_group_size,
+            (height + downsample_group_size - 1) / downsample_group_size,
+            layers);
+
+        // the next dispatch reads this level, the shaders of later submissions read all of them
+        level_barrier.subresourceRange.baseMipLevel = level;
+        list->pipeline_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, nullptr, 0, &level_barrier, 1);
+    }
+
+    m_in_flight.push_back(std::move(resources));
+}
+
+void mip_generator::create_compute_pipeline()
+{
+    VkDevice logical_device = m_device->get_logical_device();
+
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = 0.0f;
+
+    VK_CHECK(vkCreateSampler(logical_device, &sampler_info, nullptr, &m_sampler), "failed to create mip sampler");
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo set_layout_info {};
+    set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    set_layout_info.pBindings = bindings.data();
+
+    VK_CHECK(vkCreateDescriptorSetLayout(logical_device, &set_layout_info, nullptr, &m_set_layout), "failed to create mip descriptor set layout");
+
+    VkPipelineLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &m_set_layout;
+
+    VK_CHECK(vkCreatePipelineLayout(logical_device, &layout_info, nullptr, &m_pipeline_layout), "failed to create mip pipeline layout");
+
+    shader downsample_shader("mip downsample", downsample_source, EShLangCompute);
+    VkShaderModule module = downsample_shader.createShaderModule(logical_device);
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = m_pipeline_layout;
+
+    VK_CHECK(vkCreateComputePipelines(logical_device, m_pipeline_cache, 1, &pipeline_info, nullptr, &m_pipeline), "failed to create mip pipeline");
+
+    vkDestroyShaderModule(logical_device, module, nullptr);
+}
+
+void mip_generator::release_completed()
+{
+    VkDevice logical_device = m_device->get_logical_device();
+
+    std::erase_if(m_in_flight, [&](const compute_resources& resources) {
+        if (!resources.submitted || !m_device->is_complete(resources.point)) {
+            return false;
+        }
+        for (VkImageView view : resources.views) {
+            vkDestroyImageView(logical_device, view, nullptr);
+        }
+        vkDestroyDescriptorPool(logical_device, resources.descriptor_pool, nullptr);
+        return true;
+    });
+}
+
+} // namespace quix
+
+#endif // _QUIX_MIPMAP_CPP
@@ -0,0 +1,81 @@
+#ifndef _QUIX_MIPMAP_HPP
+#define _QUIX_MIPMAP_HPP
+
+namespace quix {
+
+class device;
+class command_list;
+
+enum class mip_method {
+    // the format can neither be blitted with a linear filter nor written from a shader, images keep a single level
+    none,
+    blit,
+    // 2x2 box filter in a compute shader for float and normalized formats without linear blit support,
+    // the image needs VK_IMAGE_USAGE_STORAGE_BIT
+    compute,
+};
+
+NODISCARD uint32_t get_full_mip_count(VkExtent3D extent) noexcept;
+
+// what the generator reads from an image, copied out of the image_handle so a handle that moved is never touched
+struct mip_image {
+    VkImage image = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent3D extent {};
+    uint32_t mip_levels = 1;
+    uint32_t array_layers = 1;
+};
+
+// fills every level of an image from its first one on a queue with graphics support
+class mip_generator {
+public:
+    // pipeline_cache is the device's shared cache, e.g. pipeline_manager::get_pipeline_cache(), it has to outlive the generator
+    explicit mip_generator(weakref<device> p_device, VkPipelineCache pipeline_cache = VK_NULL_HANDLE);
+    ~mip_generator();
+
+    mip_generator(const mip_generator&) = delete;
+    mip_generator& operator=(const mip_generator&) = delete;
+    mip_generator(mip_generator&&) = delete;
+    mip_generator& operator=(mip_generator&&) = delete;
+
+    NODISCARD mip_method get_method(VkFormat format) const;
+    // for a cache that only shows up after the generator, it is used if the compute pipeline was not created yet
+    void set_pipeline_cache(VkPipelineCache pipeline_cache);
+
+    // every level has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with the first one written by the transfer stage,
+    // every level ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, owner is a never reused id of whoever submits
+    // list, e.g. an upload batch id, and has to be passed to track_submit once list went out
+    void record(command_list* list, const mip_image& image, uint64_t owner);
+
+    // the views and descriptor sets recorded for owner since its last submit are freed once point is reached
+    void track_submit(uint64_t owner, timeline_point point);
+
+private:
+    void record_blit(command_list* list, const mip_image& image);
+    void record_compute(command_list* list, const mip_image& image, uint64_t owner);
+    void create_compute_pipeline();
+    void release_completed();
+
+    struct compute_resources {
+        uint64_t owner = 0;
+        timeline_point point {};
+        bool submitted = false;
+        VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+        std::vector<VkImageView> views {};
+    };
+
+    weakref<device> m_device;
+    VkPipelineCache m_pipeline_cache;
+
+    std::mutex m_mutex;
+    VkDescriptorSetLayout m_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+
+    std::vector<compute_resources> m_in_flight {};
+};
+
+} // namespace quix
+
+#endif // _QUIX_MIPMAP_HPP
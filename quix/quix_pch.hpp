@@ -18,16 +18,22 @@
 #include <stb_image.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <ranges>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -35,6 +41,7 @@
 #undef assert
 
 #include <cmath>
+#include <cstring>
 
 #define NODISCARD [[nodiscard]]
 #define MAYBEUNUSED [[maybe_unused]]
@@ -3,6 +3,9 @@
 
 #include "quix_pipeline.hpp"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <utility>
 
 #include "quix_device.hpp"
@@ -39,14 +42,44 @@ namespace graphics {
         pipeline_create_info.basePipelineHandle = nullptr;
         pipeline_create_info.basePipelineIndex = -1;
 
+        if (m_render_target.get() != nullptr && m_render_target->is_dynamic()) {
+            m_dynamic_rendering = true;
+            m_formats = m_render_target->get_rendering_formats();
+        }
+
         init_pipeline_defaults();
     }
 
+    pipeline_builder::pipeline_builder(weakref<device> p_device, const rendering_formats& formats, weakref<pipeline_manager> p_pipeline_manager)
+        : pipeline_builder(std::move(p_device), weakref<render_target>(static_cast<render_target*>(nullptr)), std::move(p_pipeline_manager))
+    {
+        quix_assert(m_device->get_enabled_features().vulkan13.dynamicRendering == VK_TRUE, "pipelines built against formats need the dynamicRendering feature");
+        quix_assert(formats.color_format_count <= rendering_formats::max_color_attachments, "too many color attachment formats");
+
+        m_dynamic_rendering = true;
+        m_formats = formats;
+    }
+
     NODISCARD std::shared_ptr<pipeline> pipeline_builder::create_graphics_pipeline()
     {
         create_pipeline_layout_info();
 
-        return allocate_shared<pipeline>(&m_pipeline_manager->m_allocator, m_device, m_render_target, &m_layout_info, &pipeline_create_info);
+        // filled in here rather than on construction since the builder is returned by value
+        pipeline_create_info.pNext = nullptr;
+        if (m_dynamic_rendering) {
+            m_rendering_info = VkPipelineRenderingCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                .pNext = nullptr,
+                .viewMask = 0,
+                .colorAttachmentCount = m_formats.color_format_count,
+                .pColorAttachmentFormats = m_formats.color_formats.data(),
+                .depthAttachmentFormat = m_formats.depth_format,
+                .stencilAttachmentFormat = m_formats.stencil_format
+            };
+            pipeline_create_info.pNext = &m_rendering_info;
+        }
+
+        return allocate_shared<pipeline>(&m_pipeline_manager->m_allocator, m_device, m_render_target, &m_layout_info, &pipeline_create_info, m_pipeline_manager->get_pipeline_cache());
 
         // return m_pipeline_manager->allocate_shared<pipeline>(m_device, m_render_target, &m_layout_info, &pipeline_create_info);
 
@@ -101,12 +134,13 @@ namespace graphics {
     pipeline::pipeline(weakref<device> p_device,
         weakref<render_target> p_render_target,
         const VkPipelineLayoutCreateInfo* pipeline_layout_info,
-        VkGraphicsPipelineCreateInfo* pipeline_create_info)
+        VkGraphicsPipelineCreateInfo* pipeline_create_info,
+        VkPipelineCache pipeline_cache)
         : m_device(std::move(p_device))
         , m_render_target(std::move(p_render_target))
     {
         create_pipeline_layout(pipeline_layout_info);
-        create_pipeline(pipeline_create_info);
+        create_pipeline(pipeline_create_info, pipeline_cache);
         for (uint32_t i = 0; i < pipeline_create_info->stageCount; i++) {
             vkDestroyShaderModule(m_device->get_logical_device(), pipeline_create_info->pStages[i].module, nullptr);
         }
@@ -114,8 +148,10 @@ namespace graphics {
 
     pipeline::~pipeline()
     {
-        vkDestroyPipelineLayout(m_device->get_logical_device(), m_pipeline_layout, nullptr);
-        vkDestroyPipeline(m_device->get_logical_device(), m_pipeline, nullptr);
+        m_device->defer_destroy([logical_device = m_device->get_logical_device(), layout = m_pipeline_layout, vk_pipeline = m_pipeline]() {
+            vkDestroyPipelineLayout(logical_device, layout, nullptr);
+            vkDestroyPipeline(logical_device, vk_pipeline, nullptr);
+        });
     }
 
     void pipeline::create_pipeline_layout(const VkPipelineLayoutCreateInfo* pipeline_layout_info)
@@ -127,21 +163,115 @@ namespace graphics {
         VK_CHECK(vkCreatePipelineLayout(m_device->get_logical_device(), pipeline_layout_info, nullptr, &m_pipeline_layout), "failed to create pipeline layout");
     }
 
-    void pipeline::create_pipeline(VkGraphicsPipelineCreateInfo* pipeline_create_info)
+    void pipeline::create_pipeline(VkGraphicsPipelineCreateInfo* pipeline_create_info, VkPipelineCache pipeline_cache)
     {
         pipeline_create_info->layout = m_pipeline_layout;
-        pipeline_create_info->renderPass = m_render_target->get_render_pass();
+        // pipelines for dynamic rendering have no render target or one without a render pass
+        pipeline_create_info->renderPass = m_render_target.get() != nullptr ? m_render_target->get_render_pass() : VK_NULL_HANDLE;
 
-        VK_CHECK(vkCreateGraphicsPipelines(m_device->get_logical_device(), VK_NULL_HANDLE, 1, pipeline_create_info, nullptr, &m_pipeline), "failed to create graphics pipeline");
+        VK_CHECK(vkCreateGraphicsPipelines(m_device->get_logical_device(), pipeline_cache, 1, pipeline_create_info, nullptr, &m_pipeline), "failed to create graphics pipeline");
     }
 
     // pipeline class end
 
     // pipeline_manager class
 
-    pipeline_manager::pipeline_manager(weakref<device> device)
+    pipeline_manager::pipeline_manager(weakref<device> device, std::string cache_path)
         : m_device(std::move(device))
+        , m_cache_path(std::move(cache_path))
+    {
+        create_pipeline_cache();
+    }
+
+    pipeline_manager::~pipeline_manager()
+    {
+        save_cache();
+        vkDestroyPipelineCache(m_device->get_logical_device(), m_pipeline_cache, nullptr);
+    }
+
+    bool pipeline_manager::save_cache()
+    {
+        if (m_cache_path.empty()) {
+            return false;
+        }
+
+        // other threads may grow the cache between the size query and the copy, VK_INCOMPLETE asks for another round
+        std::size_t size = 0;
+        std::vector<char> data {};
+        VkResult result = VK_INCOMPLETE;
+        while (result == VK_INCOMPLETE) {
+            VK_CHECK(vkGetPipelineCacheData(m_device->get_logical_device(), m_pipeline_cache, &size, nullptr), "failed to get pipeline cache size");
+            data.resize(size);
+            result = vkGetPipelineCacheData(m_device->get_logical_device(), m_pipeline_cache, &size, data.data());
+        }
+        VK_CHECK(result, "failed to get pipeline cache data");
+
+        // write next to the old cache and swap it in, so a crash mid write never leaves a truncated cache behind
+        const std::string temp_path = m_cache_path + ".tmp";
+        std::error_code error;
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(size));
+            file.close();
+            if (!file) {
+                spdlog::warn("failed to write pipeline cache to {}", temp_path);
+                std::filesystem::remove(temp_path, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp_path, m_cache_path, error);
+        if (error) {
+            spdlog::warn("failed to replace pipeline cache {}: {}", m_cache_path, error.message());
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    void pipeline_manager::create_pipeline_cache()
     {
+        std::vector<char> data {};
+
+        if (!m_cache_path.empty()) {
+            std::ifstream file(m_cache_path, std::ios::binary | std::ios::ate);
+            if (file.is_open()) {
+                data.resize(static_cast<std::size_t>(file.tellg()));
+                file.seekg(0);
+                file.read(data.data(), static_cast<std::streamsize>(data.size()));
+            }
+
+            if (!data.empty() && !is_cache_compatible(data)) {
+                spdlog::info("pipeline cache {} was created by a different device or driver, discarding it", m_cache_path);
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cache_info {};
+        cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cache_info.initialDataSize = data.size();
+        cache_info.pInitialData = data.empty() ? nullptr : data.data();
+
+        VK_CHECK(vkCreatePipelineCache(m_device->get_logical_device(), &cache_info, nullptr, &m_pipeline_cache), "failed to create pipeline cache");
+    }
+
+    NODISCARD bool pipeline_manager::is_cache_compatible(const std::vector<char>& data) const
+    {
+        VkPipelineCacheHeaderVersionOne header {};
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(m_device->get_physical_device(), &properties);
+
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
     }
 
     pipeline_builder pipeline_manager::create_pipeline_builder(render_target* p_render_target)
@@ -152,6 +282,15 @@ namespace graphics {
             make_weakref<pipeline_manager>(this)};
     }
 
+    pipeline_builder pipeline_manager::create_pipeline_builder(const rendering_formats& formats)
+    {
+        return pipeline_builder {
+            m_device,
+            formats,
+            make_weakref<pipeline_manager>(this)
+        };
+    }
+
     // pipeline_manager class end
 
 } // namespace graphics
@@ -12,9 +12,10 @@ namespace graphics {
     class pipeline_manager {
         friend class pipeline_builder;
     public:
-        explicit pipeline_manager(weakref<device> s_device);
+        // cache_path may be empty, the cache is then shared between pipelines but never persisted
+        pipeline_manager(weakref<device> s_device, std::string cache_path);
 
-        ~pipeline_manager() = default;
+        ~pipeline_manager();
 
         pipeline_manager(const pipeline_manager&) = delete;
         pipeline_manager& operator=(const pipeline_manager&) = delete;
@@ -22,10 +23,20 @@ namespace graphics {
         pipeline_manager& operator=(pipeline_manager&&) = delete;
 
         pipeline_builder create_pipeline_builder(render_target* p_render_target);
+        pipeline_builder create_pipeline_builder(const rendering_formats& formats);
+
+        NODISCARD inline VkPipelineCache get_pipeline_cache() const noexcept { return m_pipeline_cache; }
+        // also called on destruction, returns false when there is no path or the file could not be written
+        bool save_cache();
 
     private:
+        void create_pipeline_cache();
+        NODISCARD bool is_cache_compatible(const std::vector<char>& data) const;
+
         std::pmr::monotonic_buffer_resource m_allocator;
         weakref<device> m_device;
+        std::string m_cache_path;
+        VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
     };
 
 } // namespace graphics
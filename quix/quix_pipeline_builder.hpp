@@ -16,7 +16,8 @@ namespace graphics {
         pipeline(weakref<device> p_device,
             weakref<render_target> p_render_target,
             const VkPipelineLayoutCreateInfo* pipeline_layout_info,
-            VkGraphicsPipelineCreateInfo* pipeline_create_info);
+            VkGraphicsPipelineCreateInfo* pipeline_create_info,
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE);
         ~pipeline();
 
         pipeline(const pipeline&) = delete;
@@ -35,7 +36,7 @@ namespace graphics {
         VkPipeline m_pipeline = VK_NULL_HANDLE;
 
         void create_pipeline_layout(const VkPipelineLayoutCreateInfo* pipeline_layout_info);
-        void create_pipeline(VkGraphicsPipelineCreateInfo* pipeline_create_info);
+        void create_pipeline(VkGraphicsPipelineCreateInfo* pipeline_create_info, VkPipelineCache pipeline_cache);
     };
 
     class pipeline_builder {
@@ -43,6 +44,8 @@ namespace graphics {
 
     public:
         pipeline_builder(weakref<device> p_device, weakref<render_target> p_render_target, weakref<pipeline_manager> p_pipeline_manager);
+        // dynamic rendering, the pipeline only knows the attachment formats and works with any target that matches them
+        pipeline_builder(weakref<device> p_device, const rendering_formats& formats, weakref<pipeline_manager> p_pipeline_manager);
 
         NODISCARD VkPipelineShaderStageCreateInfo create_shader_stage(
             const char* file_path, const VkShaderStageFlagBits shader_stage);
@@ -75,6 +78,11 @@ namespace graphics {
         VkPipelineLayoutCreateInfo m_layout_info {};
         VkGraphicsPipelineCreateInfo pipeline_create_info {};
 
+        // chained into pipeline_create_info when building for dynamic rendering
+        bool m_dynamic_rendering = false;
+        rendering_formats m_formats {};
+        VkPipelineRenderingCreateInfo m_rendering_info {};
+
         inline void init_pipeline_defaults()
         {
             create_vertex_state(nullptr, 0, nullptr, 0);
@@ -0,0 +1,210 @@
+#ifndef _QUIX_QUERY_CPP
+#define _QUIX_QUERY_CPP
+
+#include "quix_query.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+
+namespace quix {
+
+query_scope::query_scope(query_profiler* profiler, command_list* list, uint32_t index, bool statistics)
+    : m_profiler(profiler)
+    , m_list(list)
+    , m_index(index)
+    , m_statistics(statistics)
+{
+}
+
+query_scope::~query_scope()
+{
+    m_profiler->end_scope(m_list, m_index, m_statistics);
+}
+
+query_profiler::query_profiler(weakref<device> p_device, int frames_in_flight, uint32_t max_scopes, bool pipeline_statistics)
+    : m_device(std::move(p_device))
+    , m_frames_in_flight(frames_in_flight)
+    , m_max_scopes(max_scopes)
+    , m_frames(frames_in_flight)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->get_physical_device(), &properties);
+
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->get_physical_device(), &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->get_physical_device(), &family_count, families.data());
+
+    const uint32_t valid_bits = families[m_device->get_queue_family(queue_type::graphics)].timestampValidBits;
+    quix_assert(valid_bits != 0, "graphics queue does not support timestamps");
+
+    m_timestamp_period = static_cast<double>(properties.limits.timestampPeriod);
+    m_timestamp_mask = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo timestamp_info {};
+    timestamp_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    timestamp_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    timestamp_info.queryCount = static_cast<uint32_t>(frames_in_flight) * max_scopes * 2;
+
+    VK_CHECK(vkCreateQueryPool(m_device->get_logical_device(), &timestamp_info, nullptr, &m_timestamp_pool), "failed to create timestamp query pool");
+
+    if (pipeline_statistics && m_device->get_enabled_features().core.features.pipelineStatisticsQuery != VK_TRUE) {
+        spdlog::warn("pipelineStatisticsQuery was not enabled on the device, profiling timestamps only");
+        pipeline_statistics = false;
+    }
+
+    if (pipeline_statistics) {
+        VkQueryPoolCreateInfo statistics_info {};
+        statistics_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statistics_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statistics_info.queryCount = static_cast<uint32_t>(frames_in_flight) * max_scopes;
+        // results come back in bit order, vertex invocations first
+        statistics_info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        VK_CHECK(vkCreateQueryPool(m_device->get_logical_device(), &statistics_info, nullptr, &m_statistics_pool), "failed to create pipeline statistics query pool");
+    }
+
+    // large enough for either pool, timestamps use two values per query and statistics three, each with availability
+    m_readback.resize(static_cast<std::size_t>(max_scopes) * 4);
+
+    for (auto& frame : m_frames) {
+        frame.names.reserve(max_scopes);
+        frame.depths.reserve(max_scopes);
+        frame.statistics.reserve(max_scopes);
+    }
+}
+
+query_profiler::~query_profiler()
+{
+    vkDestroyQueryPool(m_device->get_logical_device(), m_timestamp_pool, nullptr);
+    if (m_statistics_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_device->get_logical_device(), m_statistics_pool, nullptr);
+    }
+}
+
+void query_profiler::begin_frame(command_list* list, const int frame)
+{
+    quix_assert(frame < m_frames_in_flight, "frame index out of range");
+
+    resolve(frame);
+
+    auto& scopes = m_frames[frame];
+    scopes.names.clear();
+    scopes.depths.clear();
+    scopes.statistics.clear();
+
+    m_current_frame = frame;
+    m_depth = 0;
+    m_statistics_active = false;
+
+    vkCmdResetQueryPool(list->get_cmd_buffer(), m_timestamp_pool, first_query(frame) * 2, m_max_scopes * 2);
+    if (m_statistics_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(list->get_cmd_buffer(), m_statistics_pool, first_query(frame), m_max_scopes);
+    }
+}
+
+NODISCARD query_scope query_profiler::scope(command_list* list, const char* name)
+{
+    auto& scopes = m_frames[m_current_frame];
+    const auto index = static_cast<uint32_t>(scopes.names.size());
+    quix_assert(index < m_max_scopes, "too many query scopes in one frame");
+
+    const bool statistics = m_statistics_pool != VK_NULL_HANDLE && !m_statistics_active;
+
+    scopes.names.push_back(name);
+    scopes.depths.push_back(m_depth);
+    scopes.statistics.push_back(statistics);
+    m_depth++;
+
+    const uint32_t query = first_query(m_current_frame) + index;
+
+    vkCmdWriteTimestamp(list->get_cmd_buffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_pool, query * 2);
+    if (statistics) {
+        vkCmdBeginQuery(list->get_cmd_buffer(), m_statistics_pool, query, 0);
+        m_statistics_active = true;
+    }
+
+    return query_scope { this, list, index, statistics };
+}
+
+void query_profiler::end_scope(command_list* list, uint32_t index, bool statistics)
+{
+    const uint32_t query = first_query(m_current_frame) + index;
+
+    if (statistics) {
+        vkCmdEndQuery(list->get_cmd_buffer(), m_statistics_pool, query);
+        m_statistics_active = false;
+    }
+    vkCmdWriteTimestamp(list->get_cmd_buffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, query * 2 + 1);
+
+    m_depth--;
+}
+
+void query_profiler::resolve(const int frame)
+{
+    const auto& scopes = m_frames[frame];
+    const auto count = static_cast<uint32_t>(scopes.names.size());
+    if (count == 0) {
+        return;
+    }
+
+    constexpr VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+    // no wait bit, VK_NOT_READY is expected when a query is unavailable and the frame is skipped below
+    const VkResult timestamp_result = vkGetQueryPoolResults(m_device->get_logical_device(), m_timestamp_pool,
+        first_query(frame) * 2, count * 2,
+        sizeof(uint64_t) * count * 4, m_readback.data(), sizeof(uint64_t) * 2, flags);
+    if (timestamp_result != VK_SUCCESS && timestamp_result != VK_NOT_READY) {
+        VK_CHECK(timestamp_result, "failed to get timestamp query results");
+    }
+
+    gpu_frame_result results {};
+    results.scopes.reserve(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint64_t* begin = &m_readback[i * 4];
+        const uint64_t* end = &m_readback[i * 4 + 2];
+        if (begin[1] == 0 || end[1] == 0) {
+            // keep the previous results rather than publishing a partial frame
+            return;
+        }
+
+        gpu_scope_result scope {};
+        scope.name = scopes.names[i];
+        scope.depth = scopes.depths[i];
+        scope.gpu_ms = static_cast<double>((end[0] - begin[0]) & m_timestamp_mask) * m_timestamp_period / 1000000.0;
+        results.scopes.push_back(scope);
+    }
+
+    if (m_statistics_pool != VK_NULL_HANDLE) {
+        const VkResult statistics_result = vkGetQueryPoolResults(m_device->get_logical_device(), m_statistics_pool,
+            first_query(frame), count,
+            sizeof(uint64_t) * count * 3, m_readback.data(), sizeof(uint64_t) * 3, flags);
+        if (statistics_result != VK_SUCCESS && statistics_result != VK_NOT_READY) {
+            VK_CHECK(statistics_result, "failed to get pipeline statistics query results");
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t* values = &m_readback[i * 3];
+            if (!scopes.statistics[i] || values[2] == 0) {
+                continue;
+            }
+            results.scopes[i].vertex_invocations = values[0];
+            results.scopes[i].fragment_invocations = values[1];
+        }
+    }
+
+    for (const auto& scope : results.scopes) {
+        if (scope.depth == 0) {
+            results.gpu_ms += scope.gpu_ms;
+            results.vertex_invocations += scope.vertex_invocations;
+            results.fragment_invocations += scope.fragment_invocations;
+        }
+    }
+
+    m_results = std::move(results);
+}
+
+} // namespace quix
+
+#endif // _QUIX_QUERY_CPP
@@ -0,0 +1,104 @@
+#ifndef _QUIX_QUERY_HPP
+#define _QUIX_QUERY_HPP
+
+namespace quix {
+
+class device;
+class command_list;
+class query_profiler;
+
+struct gpu_scope_result {
+    const char* name = nullptr;
+    uint32_t depth = 0;
+    double gpu_ms = 0.0;
+    // only filled in when the profiler was created with pipeline statistics
+    uint64_t vertex_invocations = 0;
+    uint64_t fragment_invocations = 0;
+};
+
+struct gpu_frame_result {
+    // sum of the top level scopes
+    double gpu_ms = 0.0;
+    uint64_t vertex_invocations = 0;
+    uint64_t fragment_invocations = 0;
+    std::vector<gpu_scope_result> scopes {};
+};
+
+// writes a timestamp pair around the commands recorded while it is alive, the statistics query of a scope
+// has to begin and end within the same subpass, so do not let a scope straddle a render pass boundary
+class query_scope {
+public:
+    query_scope(query_profiler* profiler, command_list* list, uint32_t index, bool statistics);
+    ~query_scope();
+
+    query_scope(const query_scope&) = delete;
+    query_scope& operator=(const query_scope&) = delete;
+    query_scope(query_scope&&) = delete;
+    query_scope& operator=(query_scope&&) = delete;
+
+private:
+    query_profiler* m_profiler;
+    command_list* m_list;
+    uint32_t m_index;
+    bool m_statistics;
+};
+
+// per frame in flight query pools, results of a frame slot are read back the next time the slot is begun,
+// by then sync has already waited for it so reading never stalls and results lag frames_in_flight frames behind
+class query_profiler {
+    friend class query_scope;
+
+public:
+    query_profiler(weakref<device> p_device, int frames_in_flight, uint32_t max_scopes, bool pipeline_statistics);
+    ~query_profiler();
+
+    query_profiler(const query_profiler&) = delete;
+    query_profiler& operator=(const query_profiler&) = delete;
+    query_profiler(query_profiler&&) = delete;
+    query_profiler& operator=(query_profiler&&) = delete;
+
+    // resolves the previous results of this frame slot and resets its queries, record before any render pass begins
+    void begin_frame(command_list* list, const int frame);
+
+    // name must outlive the results, string literals are expected
+    NODISCARD query_scope scope(command_list* list, const char* name);
+
+    NODISCARD inline const gpu_frame_result& get_results() const noexcept { return m_results; }
+    NODISCARD inline bool has_pipeline_statistics() const noexcept { return m_statistics_pool != VK_NULL_HANDLE; }
+
+private:
+    void resolve(const int frame);
+    void end_scope(command_list* list, uint32_t index, bool statistics);
+
+    NODISCARD inline uint32_t first_query(const int frame) const noexcept { return static_cast<uint32_t>(frame) * m_max_scopes; }
+
+    weakref<device> m_device;
+
+    int m_frames_in_flight;
+    uint32_t m_max_scopes;
+
+    VkQueryPool m_timestamp_pool = VK_NULL_HANDLE;
+    VkQueryPool m_statistics_pool = VK_NULL_HANDLE;
+
+    double m_timestamp_period = 0.0;
+    uint64_t m_timestamp_mask = 0;
+
+    struct frame_scopes {
+        std::vector<const char*> names {};
+        std::vector<uint32_t> depths {};
+        std::vector<bool> statistics {};
+    };
+
+    std::vector<frame_scopes> m_frames {};
+    int m_current_frame = 0;
+    uint32_t m_depth = 0;
+    // a pool can only have one statistics query active at a time, nested scopes only get timestamps
+    bool m_statistics_active = false;
+
+    std::vector<uint64_t> m_readback {};
+    gpu_frame_result m_results {};
+};
+
+} // namespace quix
+
+#endif // _QUIX_QUERY_HPP
@@ -0,0 +1,198 @@
+#ifndef _QUIX_REGISTRY_CPP
+#define _QUIX_REGISTRY_CPP
+
+#include "quix_registry.hpp"
+
+#include "quix_device.hpp"
+
+namespace quix {
+
+resource_registry::resource_registry(weakref<device> p_device)
+    : m_device(std::move(p_device))
+{
+}
+
+resource_registry::~resource_registry()
+{
+    std::vector<destroyed_resource> remaining = std::move(m_destroyed);
+
+    for (uint32_t index = 0; index < m_buffers.buffers.size(); index++) {
+        if (m_buffers.buffers[index] == VK_NULL_HANDLE) {
+            continue;
+        }
+        spdlog::warn("resource registry: buffer {} was never destroyed", m_buffers.names[index].empty() ? fmt::format("#{}", index) : m_buffers.names[index]);
+        remaining.push_back(destroyed_resource { {}, m_buffers.buffers[index], VK_NULL_HANDLE, VK_NULL_HANDLE, m_buffers.allocations[index] });
+    }
+    for (uint32_t index = 0; index < m_images.images.size(); index++) {
+        if (m_images.images[index] == VK_NULL_HANDLE) {
+            continue;
+        }
+        spdlog::warn("resource registry: image {} was never destroyed", m_images.names[index].empty() ? fmt::format("#{}", index) : m_images.names[index]);
+        remaining.push_back(destroyed_resource { {}, VK_NULL_HANDLE, m_images.images[index], m_images.views[index], m_images.allocations[index] });
+    }
+
+    if (remaining.empty()) {
+        return;
+    }
+
+    // pending and leaked resources may still be used by anything submitted so far, the device frees them with the rest of its garbage
+    m_device->defer_destroy([logical_device = m_device->get_logical_device(), allocator = m_device->get_allocator(), remaining = std::move(remaining)]() {
+        free_resources(logical_device, allocator, remaining);
+    });
+}
+
+NODISCARD buffer_id resource_registry::create_buffer(const VkBufferCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info, const char* name)
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    VmaAllocationInfo allocation_info {};
+    VK_CHECK(vmaCreateBuffer(m_device->get_allocator(), create_info, alloc_info, &buffer, &allocation, &allocation_info), "failed to create buffer");
+
+    bool grew = false;
+    const buffer_id id = m_buffer_slots.acquire(&grew);
+    if (grew) {
+        m_buffers.buffers.emplace_back();
+        m_buffers.sizes.emplace_back();
+        m_buffers.mapped.emplace_back();
+        m_buffers.allocations.emplace_back();
+        m_buffers.names.emplace_back();
+    }
+
+    const uint32_t index = id.get_index();
+    m_buffers.buffers[index] = buffer;
+    m_buffers.sizes[index] = create_info->size;
+    m_buffers.mapped[index] = allocation_info.pMappedData;
+    m_buffers.allocations[index] = allocation;
+    m_buffers.names[index] = name != nullptr ? name : "";
+
+    return id;
+}
+
+NODISCARD image_id resource_registry::create_image(const VkImageCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info, VkImageAspectFlags view_aspect, const char* name)
+{
+    VkImage image = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    VK_CHECK(vmaCreateImage(m_device->get_allocator(), create_info, alloc_info, &image, &allocation, nullptr), "failed to create image");
+
+    VkImageView view = VK_NULL_HANDLE;
+    if (view_aspect != 0) {
+        VkImageViewCreateInfo view_info {};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = image;
+        view_info.viewType = create_info->arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+        if (create_info->imageType == VK_IMAGE_TYPE_1D) {
+            view_info.viewType = create_info->arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+        } else if (create_info->imageType == VK_IMAGE_TYPE_3D) {
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_3D;
+        }
+        view_info.format = create_info->format;
+        view_info.subresourceRange.aspectMask = view_aspect;
+        view_info.subresourceRange.baseMipLevel = 0;
+        view_info.subresourceRange.levelCount = create_info->mipLevels;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = create_info->arrayLayers;
+        VK_CHECK(vkCreateImageView(m_device->get_logical_device(), &view_info, nullptr, &view), "failed to create image view");
+    }
+
+    bool grew = false;
+    const image_id id = m_image_slots.acquire(&grew);
+    if (grew) {
+        m_images.images.emplace_back();
+        m_images.views.emplace_back();
+        m_images.formats.emplace_back();
+        m_images.extents.emplace_back();
+        m_images.allocations.emplace_back();
+        m_images.names.emplace_back();
+    }
+
+    const uint32_t index = id.get_index();
+    m_images.images[index] = image;
+    m_images.views[index] = view;
+    m_images.formats[index] = create_info->format;
+    m_images.extents[index] = create_info->extent;
+    m_images.allocations[index] = allocation;
+    m_images.names[index] = name != nullptr ? name : "";
+
+    return id;
+}
+
+void resource_registry::destroy(buffer_id id, timeline_point last_use)
+{
+    const uint32_t index = check(id);
+    m_destroyed.push_back(destroyed_resource { last_use, m_buffers.buffers[index], VK_NULL_HANDLE, VK_NULL_HANDLE, m_buffers.allocations[index] });
+
+    m_buffers.buffers[index] = VK_NULL_HANDLE;
+    m_buffers.sizes[index] = 0;
+    m_buffers.mapped[index] = nullptr;
+    m_buffers.allocations[index] = VK_NULL_HANDLE;
+    m_buffers.names[index].clear();
+    m_buffer_slots.release(id);
+}
+
+void resource_registry::destroy(buffer_id id)
+{
+    destroy(id, m_device->get_last_submitted(queue_type::graphics));
+}
+
+void resource_registry::destroy(image_id id, timeline_point last_use)
+{
+    const uint32_t index = check(id);
+    m_destroyed.push_back(destroyed_resource { last_use, VK_NULL_HANDLE, m_images.images[index], m_images.views[index], m_images.allocations[index] });
+
+    m_images.images[index] = VK_NULL_HANDLE;
+    m_images.views[index] = VK_NULL_HANDLE;
+    m_images.formats[index] = VK_FORMAT_UNDEFINED;
+    m_images.extents[index] = VkExtent3D {};
+    m_images.allocations[index] = VK_NULL_HANDLE;
+    m_images.names[index].clear();
+    m_image_slots.release(id);
+}
+
+void resource_registry::destroy(image_id id)
+{
+    destroy(id, m_device->get_last_submitted(queue_type::graphics));
+}
+
+void resource_registry::collect()
+{
+    const auto completed_begin = std::partition(m_destroyed.begin(), m_destroyed.end(), [this](const destroyed_resource& destroyed) {
+        return !m_device->is_complete(destroyed.point);
+    });
+    if (completed_begin == m_destroyed.end()) {
+        return;
+    }
+
+    const std::vector<destroyed_resource> completed(completed_begin, m_destroyed.end());
+    m_destroyed.erase(completed_begin, m_destroyed.end());
+    free_resources(m_device->get_logical_device(), m_device->get_allocator(), completed);
+}
+
+void resource_registry::free_resources(VkDevice logical_device, VmaAllocator allocator, const std::vector<destroyed_resource>& resources)
+{
+    if (resources.empty()) {
+        return;
+    }
+
+    std::vector<VmaAllocation> allocations {};
+    allocations.reserve(resources.size());
+
+    for (const auto& resource : resources) {
+        if (resource.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(logical_device, resource.view, nullptr);
+        }
+        if (resource.image != VK_NULL_HANDLE) {
+            vkDestroyImage(logical_device, resource.image, nullptr);
+        }
+        if (resource.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(logical_device, resource.buffer, nullptr);
+        }
+        allocations.push_back(resource.allocation);
+    }
+
+    // the objects are gone, their memory goes back in one call
+    vmaFreeMemoryPages(allocator, allocations.size(), allocations.data());
+}
+
+} // namespace quix
+
+#endif // _QUIX_REGISTRY_CPP
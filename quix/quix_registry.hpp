@@ -0,0 +1,187 @@
+#ifndef _QUIX_REGISTRY_HPP
+#define _QUIX_REGISTRY_HPP
+
+namespace quix {
+
+class device;
+
+// 32 bit handle, the low bits address a slot and the high bits hold the generation the slot had when the handle
+// was made, so a handle to a destroyed resource is caught instead of aliasing whatever reuses its slot
+template <typename Tag>
+struct resource_handle {
+    static constexpr uint32_t index_bits = 20;
+    static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+    static constexpr uint32_t max_generation = (1u << (32 - index_bits)) - 1;
+
+    // 0 is never handed out, generations start at 1
+    uint32_t value = 0;
+
+    NODISCARD constexpr uint32_t get_index() const noexcept { return value & index_mask; }
+    NODISCARD constexpr uint32_t get_generation() const noexcept { return value >> index_bits; }
+    NODISCARD constexpr bool is_null() const noexcept { return value == 0; }
+
+    NODISCARD static constexpr resource_handle make(uint32_t index, uint32_t generation) noexcept
+    {
+        return resource_handle { (generation << index_bits) | index };
+    }
+
+    constexpr bool operator==(const resource_handle&) const noexcept = default;
+};
+
+using buffer_id = resource_handle<struct buffer_tag>;
+using image_id = resource_handle<struct image_tag>;
+
+// hands out slots and tracks their generations, the pools keep their fields in arrays indexed by slot
+template <typename Handle>
+class handle_slots {
+public:
+    // grew is set when the slot is new and every array of the pool has to be extended by one
+    NODISCARD Handle acquire(bool* grew)
+    {
+        if (!m_free.empty()) {
+            const uint32_t index = m_free.back();
+            m_free.pop_back();
+            *grew = false;
+            return Handle::make(index, m_generations[index]);
+        }
+
+        const auto index = static_cast<uint32_t>(m_generations.size());
+        quix_assert(index <= Handle::index_mask, "resource registry is out of slots");
+        m_generations.push_back(1);
+        *grew = true;
+        return Handle::make(index, 1);
+    }
+
+    // slots whose generation would wrap are retired for good rather than risk a stale handle matching again
+    void release(Handle handle)
+    {
+        const uint32_t index = handle.get_index();
+        if (m_generations[index] == Handle::max_generation) {
+            m_generations[index] = 0;
+            return;
+        }
+        m_generations[index]++;
+        m_free.push_back(index);
+    }
+
+    NODISCARD inline bool contains(Handle handle) const noexcept
+    {
+        return !handle.is_null() && handle.get_index() < m_generations.size() && m_generations[handle.get_index()] == handle.get_generation();
+    }
+
+    NODISCARD inline uint32_t get_live_count() const noexcept
+    {
+        return static_cast<uint32_t>(m_generations.size() - m_free.size()) - get_retired_count();
+    }
+
+    NODISCARD inline uint32_t get_slot_count() const noexcept { return static_cast<uint32_t>(m_generations.size()); }
+
+private:
+    NODISCARD inline uint32_t get_retired_count() const noexcept
+    {
+        return static_cast<uint32_t>(std::count(m_generations.begin(), m_generations.end(), 0u));
+    }
+
+    std::vector<uint32_t> m_generations {};
+    std::vector<uint32_t> m_free {};
+};
+
+// owns buffers and images behind generational handles, the fields read while recording draws sit in tightly packed
+// arrays of their own and the rest stays out of the way, destroyed resources are freed together by collect() once
+// their last use has completed, anything alive when the registry goes away is reported as a leak, not thread safe
+class resource_registry {
+public:
+    explicit resource_registry(weakref<device> p_device);
+    ~resource_registry();
+
+    resource_registry(const resource_registry&) = delete;
+    resource_registry& operator=(const resource_registry&) = delete;
+    resource_registry(resource_registry&&) = delete;
+    resource_registry& operator=(resource_registry&&) = delete;
+
+    // name is only kept for leak reports and may be null
+    NODISCARD buffer_id create_buffer(const VkBufferCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info, const char* name = nullptr);
+    // a view of the whole image is created when view_aspect is not 0
+    NODISCARD image_id create_image(const VkImageCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info, VkImageAspectFlags view_aspect,
+        const char* name = nullptr);
+
+    // the handle is invalid right away, the resource is freed by the first collect() after last_use completed,
+    // the overloads without a point take the last graphics submission
+    void destroy(buffer_id id, timeline_point last_use);
+    void destroy(buffer_id id);
+    void destroy(image_id id, timeline_point last_use);
+    void destroy(image_id id);
+    // frees every destroyed resource whose last use completed, with one vma call for all of their memory
+    void collect();
+
+    NODISCARD inline bool is_valid(buffer_id id) const noexcept { return m_buffer_slots.contains(id); }
+    NODISCARD inline bool is_valid(image_id id) const noexcept { return m_image_slots.contains(id); }
+
+    NODISCARD inline VkBuffer get_buffer(buffer_id id) const noexcept { return m_buffers.buffers[check(id)]; }
+    NODISCARD inline VkDeviceSize get_size(buffer_id id) const noexcept { return m_buffers.sizes[check(id)]; }
+    // null for memory that is not persistently mapped
+    NODISCARD inline void* get_mapped_data(buffer_id id) const noexcept { return m_buffers.mapped[check(id)]; }
+
+    NODISCARD inline VkImage get_image(image_id id) const noexcept { return m_images.images[check(id)]; }
+    NODISCARD inline VkImageView get_view(image_id id) const noexcept { return m_images.views[check(id)]; }
+    NODISCARD inline VkFormat get_format(image_id id) const noexcept { return m_images.formats[check(id)]; }
+    NODISCARD inline VkExtent3D get_extent(image_id id) const noexcept { return m_images.extents[check(id)]; }
+
+    NODISCARD inline uint32_t get_live_buffer_count() const noexcept { return m_buffer_slots.get_live_count(); }
+    NODISCARD inline uint32_t get_live_image_count() const noexcept { return m_image_slots.get_live_count(); }
+
+private:
+    template <typename Handle>
+    NODISCARD inline uint32_t check(Handle id) const noexcept
+    {
+        if constexpr (std::is_same_v<Handle, buffer_id>) {
+            quix_assert(m_buffer_slots.contains(id), "stale or null buffer handle");
+        } else {
+            quix_assert(m_image_slots.contains(id), "stale or null image handle");
+        }
+        return id.get_index();
+    }
+
+    struct buffer_pool {
+        // hot, read while recording
+        std::vector<VkBuffer> buffers {};
+        std::vector<VkDeviceSize> sizes {};
+        std::vector<void*> mapped {};
+        // cold, only touched on creation and destruction
+        std::vector<VmaAllocation> allocations {};
+        std::vector<std::string> names {};
+    };
+
+    struct image_pool {
+        std::vector<VkImage> images {};
+        std::vector<VkImageView> views {};
+        std::vector<VkFormat> formats {};
+        std::vector<VkExtent3D> extents {};
+        std::vector<VmaAllocation> allocations {};
+        std::vector<std::string> names {};
+    };
+
+    // the slot is reused right away, only the vulkan objects wait for their last use
+    struct destroyed_resource {
+        timeline_point point {};
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+    };
+
+    static void free_resources(VkDevice logical_device, VmaAllocator allocator, const std::vector<destroyed_resource>& resources);
+
+    weakref<device> m_device;
+
+    handle_slots<buffer_id> m_buffer_slots {};
+    handle_slots<image_id> m_image_slots {};
+    buffer_pool m_buffers {};
+    image_pool m_images {};
+
+    std::vector<destroyed_resource> m_destroyed {};
+};
+
+} // namespace quix
+
+#endif // _QUIX_REGISTRY_HPP
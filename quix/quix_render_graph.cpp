@@ -0,0 +1,632 @@
+#ifndef _QUIX_RENDER_GRAPH_CPP
+#define _QUIX_RENDER_GRAPH_CPP
+
+#include "quix_render_graph.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+
+namespace quix {
+
+namespace {
+
+    struct access_info {
+        VkImageLayout layout;
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageUsageFlags usage;
+        bool write;
+        bool image;
+    };
+
+    constexpr access_info get_access_info(graph_access access)
+    {
+        constexpr VkPipelineStageFlags depth_stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+        switch (access) {
+        case graph_access::color_attachment:
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, true };
+        case graph_access::depth_attachment:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depth_stages,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, true };
+        case graph_access::depth_read:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depth_stages,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false, true };
+        case graph_access::sampled_fragment:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, false, true };
+        case graph_access::sampled_compute:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, false, true };
+        case graph_access::storage_read_compute:
+            return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_STORAGE_BIT, false, true };
+        case graph_access::storage_write_compute:
+            return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_USAGE_STORAGE_BIT, true, true };
+        case graph_access::transfer_src:
+            return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false, true };
+        case graph_access::transfer_dst:
+            return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, true };
+        case graph_access::vertex_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0, false, false };
+        case graph_access::index_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                VK_ACCESS_INDEX_READ_BIT, 0, false, false };
+        case graph_access::indirect_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                VK_ACCESS_INDIRECT_COMMAND_READ_BIT, 0, false, false };
+        case graph_access::uniform_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_UNIFORM_READ_BIT, 0, false, false };
+        case graph_access::storage_buffer_read:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT, 0, false, false };
+        case graph_access::storage_buffer_write:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, 0, true, false };
+        }
+        return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, 0, true, false };
+    }
+
+    constexpr VkAccessFlags write_access_mask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    NODISCARD VkImageAspectFlags get_aspect(VkFormat format)
+    {
+        switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    // what has happened to a resource so far while walking the passes, write_stage and write_access describe the last
+    // write or layout transition, read_stage the stages that have already been made to wait for it, write_access is
+    // always supported by write_stage so barriers built from the two are valid pairs
+    struct tracked_state {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags write_stage = 0;
+        VkAccessFlags write_access = 0;
+        VkPipelineStageFlags read_stage = 0;
+    };
+
+} // namespace
+
+graph_pass::graph_pass(const char* name, graph_execute&& execute)
+    : m_name(name)
+    , m_execute(std::move(execute))
+{
+}
+
+graph_pass& graph_pass::read(graph_resource resource, graph_access access)
+{
+    quix_assert(!get_access_info(access).write, fmt::format("render graph: pass {} declares a write access as a read", m_name));
+    quix_assert(std::none_of(m_uses.begin(), m_uses.end(), [&](const resource_use& use) { return use.resource == resource; }),
+        fmt::format("render graph: pass {} uses a resource twice", m_name));
+    m_uses.push_back(resource_use { resource, access });
+    return *this;
+}
+
+graph_pass& graph_pass::write(graph_resource resource, graph_access access)
+{
+    quix_assert(get_access_info(access).write, fmt::format("render graph: pass {} declares a read access as a write", m_name));
+    quix_assert(std::none_of(m_uses.begin(), m_uses.end(), [&](const resource_use& use) { return use.resource == resource; }),
+        fmt::format("render graph: pass {} uses a resource twice", m_name));
+    m_uses.push_back(resource_use { resource, access });
+    return *this;
+}
+
+graph_pass& graph_pass::keep() noexcept
+{
+    m_keep = true;
+    return *this;
+}
+
+render_graph::render_graph(weakref<device> p_device)
+    : m_device(std::move(p_device))
+{
+}
+
+render_graph::~render_graph()
+{
+    destroy_transients();
+}
+
+NODISCARD graph_resource render_graph::create_image(const char* name, const graph_image_desc& desc)
+{
+    quix_assert(desc.format != VK_FORMAT_UNDEFINED && desc.extent.width != 0 && desc.extent.height != 0, "render graph: transient image needs a format and an extent");
+
+    graph_resource_entry entry {};
+    entry.name = name;
+    entry.desc = desc;
+    m_resources.push_back(entry);
+    m_compiled = false;
+    return static_cast<graph_resource>(m_resources.size() - 1);
+}
+
+NODISCARD graph_resource render_graph::import_image(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+    VkImageLayout initial_layout, VkImageLayout final_layout)
+{
+    graph_resource_entry entry {};
+    entry.name = name;
+    entry.imported = true;
+    entry.desc.format = format;
+    entry.desc.extent = extent;
+    entry.vk_image = image;
+    entry.view = view;
+    entry.initial_layout = initial_layout;
+    entry.final_layout = final_layout;
+    m_resources.push_back(entry);
+    m_compiled = false;
+    return static_cast<graph_resource>(m_resources.size() - 1);
+}
+
+NODISCARD graph_resource render_graph::import_buffer(const char* name, VkBuffer buffer)
+{
+    graph_resource_entry entry {};
+    entry.name = name;
+    entry.image = false;
+    entry.imported = true;
+    entry.buffer = buffer;
+    m_resources.push_back(entry);
+    m_compiled = false;
+    return static_cast<graph_resource>(m_resources.size() - 1);
+}
+
+void render_graph::set_image(graph_resource resource, VkImage image, VkImageView view)
+{
+    quix_assert(resource < m_resources.size() && m_resources[resource].imported && m_resources[resource].image, "render graph: not an imported image");
+    m_resources[resource].vk_image = image;
+    m_resources[resource].view = view;
+}
+
+void render_graph::set_buffer(graph_resource resource, VkBuffer buffer)
+{
+    quix_assert(resource < m_resources.size() && m_resources[resource].imported && !m_resources[resource].image, "render graph: not an imported buffer");
+    m_resources[resource].buffer = buffer;
+}
+
+void render_graph::mark_output(graph_resource resource)
+{
+    quix_assert(resource < m_resources.size(), "render graph: invalid resource");
+    m_resources[resource].output = true;
+    m_compiled = false;
+}
+
+graph_pass& render_graph::add_pass(const char* name, graph_execute&& execute)
+{
+    m_compiled = false;
+    return m_passes.emplace_back(name, std::move(execute));
+}
+
+void render_graph::reset()
+{
+    destroy_transients();
+    m_passes.clear();
+    m_resources.clear();
+    m_final_barriers.clear();
+    m_compiled = false;
+}
+
+void render_graph::compile()
+{
+    for (const auto& pass : m_passes) {
+        for (const auto& use : pass.m_uses) {
+            quix_assert(use.resource < m_resources.size(), fmt::format("render graph: pass {} uses an invalid resource", pass.m_name));
+            quix_assert(get_access_info(use.access).image == m_resources[use.resource].image,
+                fmt::format("render graph: pass {} uses {} with an access of the wrong kind", pass.m_name, m_resources[use.resource].name));
+        }
+    }
+
+    cull();
+    compute_lifetimes();
+    create_transients();
+    compute_barriers();
+    m_compiled = true;
+}
+
+void render_graph::cull()
+{
+    // walking backwards, a pass is needed when it writes something a later needed pass or an output depends on, writes
+    // count as dependencies too since attachments may be loaded rather than cleared
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); i++) {
+        needed[i] = m_resources[i].output;
+    }
+
+    m_culled_pass_count = 0;
+    for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass) {
+        bool keep = pass->m_keep;
+        for (const auto& use : pass->m_uses) {
+            keep |= get_access_info(use.access).write && needed[use.resource];
+        }
+
+        pass->m_culled = !keep;
+        if (!keep) {
+            m_culled_pass_count++;
+            continue;
+        }
+        for (const auto& use : pass->m_uses) {
+            needed[use.resource] = true;
+        }
+    }
+}
+
+void render_graph::compute_lifetimes()
+{
+    for (auto& resource : m_resources) {
+        resource.first_pass = invalid_pass;
+        resource.last_pass = 0;
+        resource.usage = 0;
+    }
+
+    for (uint32_t index = 0; index < m_passes.size(); index++) {
+        if (m_passes[index].m_culled) {
+            continue;
+        }
+        for (const auto& use : m_passes[index].m_uses) {
+            auto& resource = m_resources[use.resource];
+            const access_info info = get_access_info(use.access);
+            resource.first_pass = std::min(resource.first_pass, index);
+            resource.last_pass = std::max(resource.last_pass, index);
+            resource.usage |= info.usage;
+        }
+    }
+}
+
+void render_graph::create_transients()
+{
+    destroy_transients();
+
+    VkDevice vk_device = m_device->get_logical_device();
+
+    std::vector<graph_resource> transients {};
+    std::vector<VkMemoryRequirements> requirements(m_resources.size());
+    m_unaliased_memory_size = 0;
+
+    for (graph_resource id = 0; id < m_resources.size(); id++) {
+        auto& resource = m_resources[id];
+        if (resource.imported || resource.first_pass == invalid_pass) {
+            continue;
+        }
+
+        VkImageCreateInfo image_info {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = resource.desc.format;
+        image_info.extent = { resource.desc.extent.width, resource.desc.extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = resource.desc.samples;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = resource.usage;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VK_CHECK(vkCreateImage(vk_device, &image_info, nullptr, &resource.vk_image), "failed to create transient image");
+
+        vkGetImageMemoryRequirements(vk_device, resource.vk_image, &requirements[id]);
+        m_unaliased_memory_size += requirements[id].size;
+        transients.push_back(id);
+    }
+
+    // largest first, each image goes into the first block whose occupants are all dead before it is born or born after
+    // it dies, it sits at the start of the block so alignment and buffer image granularity never come into play
+    std::sort(transients.begin(), transients.end(), [&](graph_resource a, graph_resource b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    for (const graph_resource id : transients) {
+        const auto& resource = m_resources[id];
+        const VkMemoryRequirements& image_requirements = requirements[id];
+
+        memory_block* target = nullptr;
+        for (auto& block : m_blocks) {
+            if ((block.requirements.memoryTypeBits & image_requirements.memoryTypeBits) == 0) {
+                continue;
+            }
+            bool overlaps = false;
+            for (const graph_resource occupant : block.occupants) {
+                const auto& other = m_resources[occupant];
+                overlaps |= resource.first_pass <= other.last_pass && other.first_pass <= resource.last_pass;
+            }
+            if (!overlaps) {
+                target = &block;
+                break;
+            }
+        }
+
+        if (target == nullptr) {
+            target = &m_blocks.emplace_back();
+            target->requirements = image_requirements;
+        } else {
+            target->requirements.size = std::max(target->requirements.size, image_requirements.size);
+            target->requirements.alignment = std::max(target->requirements.alignment, image_requirements.alignment);
+            target->requirements.memoryTypeBits &= image_requirements.memoryTypeBits;
+        }
+        target->occupants.push_back(id);
+    }
+
+    VmaAllocationCreateInfo alloc_info {};
+    alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    m_transient_memory_size = 0;
+    for (auto& block : m_blocks) {
+        VK_CHECK(vmaAllocateMemory(m_device->get_allocator(), &block.requirements, &alloc_info, &block.allocation, nullptr), "failed to allocate transient memory");
+        m_transient_memory_size += block.requirements.size;
+
+        // occupants in the order they are used, each one has to wait for the one before it to be done with the memory
+        // and the first one for the last one of the previous frame
+        std::sort(block.occupants.begin(), block.occupants.end(), [&](graph_resource a, graph_resource b) {
+            return m_resources[a].first_pass < m_resources[b].first_pass;
+        });
+
+        for (size_t i = 0; i < block.occupants.size(); i++) {
+            auto& resource = m_resources[block.occupants[i]];
+            resource.alias_predecessor = block.occupants[(i + block.occupants.size() - 1) % block.occupants.size()];
+
+            VK_CHECK(vmaBindImageMemory(m_device->get_allocator(), block.allocation, resource.vk_image), "failed to bind transient image memory");
+
+            const VkImageAspectFlags aspect = get_aspect(resource.desc.format);
+            VkImageViewCreateInfo view_info {};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = resource.vk_image;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = resource.desc.format;
+            view_info.subresourceRange.aspectMask = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0 ? VK_IMAGE_ASPECT_DEPTH_BIT : aspect;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.layerCount = 1;
+            VK_CHECK(vkCreateImageView(vk_device, &view_info, nullptr, &resource.view), "failed to create transient image view");
+        }
+    }
+}
+
+void render_graph::destroy_transients()
+{
+    std::vector<std::pair<VkImage, VkImageView>> images {};
+    std::vector<VmaAllocation> allocations {};
+
+    for (auto& resource : m_resources) {
+        if (resource.imported || resource.vk_image == VK_NULL_HANDLE) {
+            continue;
+        }
+        images.emplace_back(resource.vk_image, resource.view);
+        resource.vk_image = VK_NULL_HANDLE;
+        resource.view = VK_NULL_HANDLE;
+    }
+    for (const auto& block : m_blocks) {
+        allocations.push_back(block.allocation);
+    }
+    m_blocks.clear();
+    m_transient_memory_size = 0;
+
+    if (images.empty() && allocations.empty()) {
+        return;
+    }
+
+    m_device->defer_destroy([vk_device = m_device->get_logical_device(), allocator = m_device->get_allocator(),
+                                images = std::move(images), allocations = std::move(allocations)]() {
+        for (const auto& [image, view] : images) {
+            vkDestroyImageView(vk_device, view, nullptr);
+            vkDestroyImage(vk_device, image, nullptr);
+        }
+        for (VmaAllocation allocation : allocations) {
+            vmaFreeMemory(allocator, allocation);
+        }
+    });
+}
+
+void render_graph::compute_barriers()
+{
+    std::vector<tracked_state> states(m_resources.size());
+    m_barrier_count = 0;
+
+    // the first walk only finds the state every resource is left in, transients start out from their alias
+    // predecessor's final state so the second walk can make them wait for whoever used the memory last
+    for (int walk = 0; walk < 2; walk++) {
+        const bool record = walk == 1;
+        std::vector<tracked_state> final_states = states;
+
+        for (graph_resource id = 0; id < m_resources.size(); id++) {
+            const auto& resource = m_resources[id];
+            if (resource.imported) {
+                states[id] = { resource.initial_layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT, 0 };
+            } else if (record) {
+                const tracked_state& predecessor = final_states[resource.alias_predecessor];
+                // the predecessor's readers stay readers so its write access is only paired with its write stage
+                states[id] = { VK_IMAGE_LAYOUT_UNDEFINED, predecessor.write_stage, predecessor.write_access, predecessor.read_stage };
+            } else {
+                states[id] = {};
+            }
+        }
+
+        for (auto& pass : m_passes) {
+            pass.m_src_stage = 0;
+            pass.m_dst_stage = 0;
+            pass.m_image_barriers.clear();
+            pass.m_buffer_barriers.clear();
+            if (pass.m_culled) {
+                continue;
+            }
+
+            for (const auto& use : pass.m_uses) {
+                const auto& resource = m_resources[use.resource];
+                const access_info info = get_access_info(use.access);
+                tracked_state& state = states[use.resource];
+
+                const VkImageLayout old_layout = state.layout;
+                const bool transition = resource.image && old_layout != info.layout;
+                VkPipelineStageFlags src_stage = 0;
+                VkAccessFlags src_access = 0;
+
+                if (info.write || transition) {
+                    // writes and layout transitions wait for every earlier access, reads never need their memory flushed
+                    src_stage = state.write_stage | state.read_stage;
+                    src_access = state.write_access & write_access_mask;
+                } else if (state.write_stage != 0 && (info.stage & ~state.read_stage) != 0) {
+                    // a read in a stage that has not waited for the last write yet, reads of the same layout in stages
+                    // that already did need nothing
+                    src_stage = state.write_stage;
+                    src_access = state.write_access & write_access_mask;
+                } else {
+                    state.read_stage |= info.stage;
+                    continue;
+                }
+
+                if (info.write) {
+                    state = { info.layout, info.stage, info.access, 0 };
+                } else {
+                    // chained through the read stages, later reads in other stages wait on them rather than on the write,
+                    // which this barrier already made available so there is no access left to pair with the read stages
+                    state.layout = resource.image ? info.layout : state.layout;
+                    state.write_stage = info.stage;
+                    state.write_access = 0;
+                    state.read_stage = info.stage;
+                }
+
+                if (!record) {
+                    continue;
+                }
+
+                pass.m_src_stage |= src_stage;
+                pass.m_dst_stage |= info.stage;
+                if (resource.image) {
+                    VkImageMemoryBarrier barrier {};
+                    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                    barrier.srcAccessMask = src_access;
+                    barrier.dstAccessMask = info.access;
+                    barrier.oldLayout = old_layout;
+                    barrier.newLayout = info.layout;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.subresourceRange = { get_aspect(resource.desc.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+                    pass.m_image_barriers.emplace_back(use.resource, barrier);
+                } else {
+                    VkBufferMemoryBarrier barrier {};
+                    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barrier.srcAccessMask = src_access;
+                    barrier.dstAccessMask = info.access;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.offset = 0;
+                    barrier.size = VK_WHOLE_SIZE;
+                    pass.m_buffer_barriers.emplace_back(use.resource, barrier);
+                }
+                m_barrier_count++;
+            }
+        }
+    }
+
+    m_final_src_stage = 0;
+    m_final_barriers.clear();
+    for (graph_resource id = 0; id < m_resources.size(); id++) {
+        const auto& resource = m_resources[id];
+        const tracked_state& state = states[id];
+        if (!resource.imported || !resource.image || resource.final_layout == VK_IMAGE_LAYOUT_UNDEFINED || resource.final_layout == state.layout) {
+            continue;
+        }
+
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = state.write_access & write_access_mask;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = resource.final_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange = { get_aspect(resource.desc.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+        m_final_src_stage |= state.write_stage | state.read_stage;
+        m_final_barriers.emplace_back(id, barrier);
+        m_barrier_count++;
+    }
+}
+
+void render_graph::execute(command_list* list)
+{
+    quix_assert(m_compiled, "render graph: compile the graph before executing it");
+
+    std::vector<VkImageMemoryBarrier> image_barriers {};
+    std::vector<VkBufferMemoryBarrier> buffer_barriers {};
+
+    for (auto& pass : m_passes) {
+        if (pass.m_culled) {
+            continue;
+        }
+
+        if (!pass.m_image_barriers.empty() || !pass.m_buffer_barriers.empty()) {
+            image_barriers.clear();
+            buffer_barriers.clear();
+            for (const auto& [resource, barrier] : pass.m_image_barriers) {
+                image_barriers.push_back(barrier);
+                image_barriers.back().image = m_resources[resource].vk_image;
+            }
+            for (const auto& [resource, barrier] : pass.m_buffer_barriers) {
+                buffer_barriers.push_back(barrier);
+                buffer_barriers.back().buffer = m_resources[resource].buffer;
+            }
+            list->pipeline_barrier(pass.m_src_stage != 0 ? pass.m_src_stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pass.m_dst_stage,
+                buffer_barriers.data(), static_cast<uint32_t>(buffer_barriers.size()),
+                image_barriers.data(), static_cast<uint32_t>(image_barriers.size()));
+        }
+
+        pass.m_execute(list, *this);
+    }
+
+    if (!m_final_barriers.empty()) {
+        image_barriers.clear();
+        for (const auto& [resource, barrier] : m_final_barriers) {
+            image_barriers.push_back(barrier);
+            image_barriers.back().image = m_resources[resource].vk_image;
+        }
+        list->pipeline_barrier(m_final_src_stage != 0 ? m_final_src_stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            nullptr, 0, image_barriers.data(), static_cast<uint32_t>(image_barriers.size()));
+    }
+}
+
+NODISCARD const render_graph::graph_resource_entry& render_graph::get_entry(graph_resource resource) const
+{
+    quix_assert(resource < m_resources.size(), "render graph: invalid resource");
+    return m_resources[resource];
+}
+
+NODISCARD VkImage render_graph::get_image(graph_resource resource) const
+{
+    return get_entry(resource).vk_image;
+}
+
+NODISCARD VkImageView render_graph::get_view(graph_resource resource) const
+{
+    return get_entry(resource).view;
+}
+
+NODISCARD VkBuffer render_graph::get_buffer(graph_resource resource) const
+{
+    return get_entry(resource).buffer;
+}
+
+NODISCARD VkFormat render_graph::get_format(graph_resource resource) const
+{
+    return get_entry(resource).desc.format;
+}
+
+NODISCARD VkExtent2D render_graph::get_extent(graph_resource resource) const
+{
+    return get_entry(resource).desc.extent;
+}
+
+} // namespace quix
+
+#endif // _QUIX_RENDER_GRAPH_CPP
@@ -0,0 +1,177 @@
+#ifndef _QUIX_RENDER_GRAPH_HPP
+#define _QUIX_RENDER_GRAPH_HPP
+
+namespace quix {
+
+class device;
+class command_list;
+class render_graph;
+
+using graph_resource = uint32_t;
+
+// how a pass touches a resource, each access implies the layout, stages and access mask of the barriers around it
+enum class graph_access : uint8_t {
+    color_attachment,
+    depth_attachment,
+    depth_read,
+    sampled_fragment,
+    sampled_compute,
+    storage_read_compute,
+    storage_write_compute,
+    transfer_src,
+    transfer_dst,
+    vertex_buffer,
+    index_buffer,
+    indirect_buffer,
+    uniform_buffer,
+    storage_buffer_read,
+    storage_buffer_write,
+};
+
+struct graph_image_desc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent {};
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+using graph_execute = std::function<void(command_list* list, const render_graph& graph)>;
+
+class graph_pass {
+    friend class render_graph;
+
+public:
+    graph_pass(const char* name, graph_execute&& execute);
+
+    graph_pass& read(graph_resource resource, graph_access access);
+    graph_pass& write(graph_resource resource, graph_access access);
+    // the pass is never culled, for passes whose effect is outside the graph like a readback
+    graph_pass& keep() noexcept;
+
+    NODISCARD inline const char* get_name() const noexcept { return m_name; }
+    NODISCARD inline bool is_culled() const noexcept { return m_culled; }
+
+private:
+    struct resource_use {
+        graph_resource resource = 0;
+        graph_access access = graph_access::color_attachment;
+    };
+
+    const char* m_name;
+    graph_execute m_execute;
+    std::vector<resource_use> m_uses {};
+    bool m_keep = false;
+    bool m_culled = false;
+
+    // filled by compile, image and buffer handles are patched in on every execute since imports may change
+    VkPipelineStageFlags m_src_stage = 0;
+    VkPipelineStageFlags m_dst_stage = 0;
+    std::vector<std::pair<graph_resource, VkImageMemoryBarrier>> m_image_barriers {};
+    std::vector<std::pair<graph_resource, VkBufferMemoryBarrier>> m_buffer_barriers {};
+};
+
+// passes are declared in execution order with the resources they read and write, compile() culls every pass that does
+// not contribute to an output, derives one batched barrier per pass from the declared accesses and places transient
+// images whose lifetimes do not overlap in the same memory, the compiled graph is executed every frame and only has to
+// be compiled again when passes or transient images change, e.g. after a resize
+class render_graph {
+public:
+    explicit render_graph(weakref<device> p_device);
+    ~render_graph();
+
+    render_graph(const render_graph&) = delete;
+    render_graph& operator=(const render_graph&) = delete;
+    render_graph(render_graph&&) = delete;
+    render_graph& operator=(render_graph&&) = delete;
+
+    // created and aliased by the graph, the contents do not survive from one frame to the next
+    NODISCARD graph_resource create_image(const char* name, const graph_image_desc& desc);
+    // owned elsewhere, the image is in initial_layout when the graph starts and is left in final_layout, the usage
+    // flags the declared accesses need are up to the owner
+    NODISCARD graph_resource import_image(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+        VkImageLayout initial_layout, VkImageLayout final_layout);
+    NODISCARD graph_resource import_buffer(const char* name, VkBuffer buffer);
+    // swaps the object behind an import without compiling again, e.g. the swapchain image of this frame
+    void set_image(graph_resource resource, VkImage image, VkImageView view);
+    void set_buffer(graph_resource resource, VkBuffer buffer);
+    // passes that contribute to no output are culled
+    void mark_output(graph_resource resource);
+
+    // the reference stays valid for the lifetime of the graph
+    graph_pass& add_pass(const char* name, graph_execute&& execute);
+    // drops every pass and resource, transient memory goes once nothing in flight can use it
+    void reset();
+
+    void compile();
+    // records every pass that survived culling with its barriers in front of it, then moves imports to their final layout
+    void execute(command_list* list);
+
+    NODISCARD VkImage get_image(graph_resource resource) const;
+    NODISCARD VkImageView get_view(graph_resource resource) const;
+    NODISCARD VkBuffer get_buffer(graph_resource resource) const;
+    NODISCARD VkFormat get_format(graph_resource resource) const;
+    NODISCARD VkExtent2D get_extent(graph_resource resource) const;
+
+    NODISCARD inline uint32_t get_culled_pass_count() const noexcept { return m_culled_pass_count; }
+    NODISCARD inline uint32_t get_barrier_count() const noexcept { return m_barrier_count; }
+    // memory actually allocated for transient images and what it would take without aliasing
+    NODISCARD inline VkDeviceSize get_transient_memory_size() const noexcept { return m_transient_memory_size; }
+    NODISCARD inline VkDeviceSize get_unaliased_memory_size() const noexcept { return m_unaliased_memory_size; }
+
+private:
+    struct graph_resource_entry {
+        const char* name = nullptr;
+        bool image = true;
+        bool imported = false;
+        bool output = false;
+
+        graph_image_desc desc {};
+        VkImageUsageFlags usage = 0;
+        VkImage vk_image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        // kept passes only, first_pass is invalid_pass for resources nothing kept uses
+        uint32_t first_pass = 0;
+        uint32_t last_pass = 0;
+        // the transient that used the same memory right before this one, possibly itself from the previous frame
+        graph_resource alias_predecessor = 0;
+    };
+
+    struct memory_block {
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkMemoryRequirements requirements {};
+        std::vector<graph_resource> occupants {};
+    };
+
+    static constexpr uint32_t invalid_pass = std::numeric_limits<uint32_t>::max();
+
+    void cull();
+    void compute_lifetimes();
+    void create_transients();
+    void destroy_transients();
+    void compute_barriers();
+
+    NODISCARD const graph_resource_entry& get_entry(graph_resource resource) const;
+
+    weakref<device> m_device;
+
+    std::vector<graph_resource_entry> m_resources {};
+    std::deque<graph_pass> m_passes {};
+    std::vector<memory_block> m_blocks {};
+    bool m_compiled = false;
+
+    // transitions of imports to their final layout after the last pass
+    VkPipelineStageFlags m_final_src_stage = 0;
+    std::vector<std::pair<graph_resource, VkImageMemoryBarrier>> m_final_barriers {};
+
+    uint32_t m_culled_pass_count = 0;
+    uint32_t m_barrier_count = 0;
+    VkDeviceSize m_transient_memory_size = 0;
+    VkDeviceSize m_unaliased_memory_size = 0;
+};
+
+} // namespace quix
+
+#endif // _QUIX_RENDER_GRAPH_HPP
@@ -51,20 +51,86 @@ render_target::render_target(weakref<window> p_window, weakref<device> p_device,
     create_framebuffers();
 }
 
+render_target::render_target(weakref<device> p_device, const VkRenderPassCreateInfo* render_pass_create_info, std::vector<VkImageView>&& attachments, VkExtent2D extent)
+    : m_window(static_cast<window*>(nullptr))
+    , m_device(std::move(p_device))
+    , m_swapchain(static_cast<swapchain*>(nullptr))
+    , m_attachments(std::move(attachments))
+    , m_extent(extent)
+{
+    create_renderpass(render_pass_create_info);
+    create_framebuffers();
+}
+
+render_target::render_target(weakref<window> p_window, weakref<device> p_device, weakref<swapchain> p_swapchain)
+    : m_window(std::move(p_window))
+    , m_device(std::move(p_device))
+    , m_swapchain(std::move(p_swapchain))
+{
+    quix_assert(m_device->get_enabled_features().vulkan13.dynamicRendering == VK_TRUE, "dynamic render targets need the dynamicRendering feature");
+}
+
 render_target::~render_target()
 {
+    if (is_dynamic()) {
+        return;
+    }
+
     destroy_framebuffers();
 
-    vkDestroyRenderPass(m_device->get_logical_device(), m_render_pass, nullptr);
+    m_device->defer_destroy([logical_device = m_device->get_logical_device(), render_pass = m_render_pass]() {
+        vkDestroyRenderPass(logical_device, render_pass, nullptr);
+    });
 }
 
 NODISCARD VkExtent2D render_target::get_extent() const noexcept
 {
+    if (is_offscreen()) {
+        return m_extent;
+    }
     return m_swapchain->get_extent();
 }
 
+NODISCARD rendering_formats render_target::get_rendering_formats() const
+{
+    quix_assert(is_dynamic() && !is_offscreen(), "only dynamic render targets have rendering formats");
+
+    rendering_formats formats {};
+    formats.color_formats[0] = m_swapchain->get_surface_format().format;
+    formats.color_format_count = 1;
+    if (get_depth_view() != VK_NULL_HANDLE) {
+        formats.depth_format = m_swapchain->depth_image->get_format();
+        if (swapchain::has_stencil_component(formats.depth_format)) {
+            formats.stencil_format = formats.depth_format;
+        }
+    }
+    return formats;
+}
+
+NODISCARD VkImage render_target::get_color_image(uint32_t image_index) const
+{
+    return m_swapchain->m_swapchain_images[image_index];
+}
+
+NODISCARD VkImageView render_target::get_color_view(uint32_t image_index) const
+{
+    return m_swapchain->m_swapchain_image_views[image_index];
+}
+
+NODISCARD VkImage render_target::get_depth_image() const
+{
+    return m_swapchain->depth_image != nullptr ? m_swapchain->depth_image->get_image() : VK_NULL_HANDLE;
+}
+
+NODISCARD VkImageView render_target::get_depth_view() const
+{
+    return m_swapchain->depth_image != nullptr ? m_swapchain->depth_image->get_view() : VK_NULL_HANDLE;
+}
+
 void render_target::recreate_swapchain()
 {
+    quix_assert(!is_offscreen(), "offscreen render targets do not have a swapchain to recreate");
+
     auto* window = m_window->get_window();
     int width = 0;
     int height = 0;
@@ -73,9 +139,11 @@ void render_target::recreate_swapchain()
         glfwWaitEvents();
     }
 
-    m_device->wait_idle();
-
+    // waits for the device to go idle, so the old framebuffers below are released by the next collection
     m_swapchain->recreate_swapchain();
+    if (is_dynamic()) {
+        return;
+    }
 
     destroy_framebuffers();
 
@@ -89,6 +157,21 @@ void render_target::create_renderpass(const VkRenderPassCreateInfo* renderpass_i
 
 void render_target::create_framebuffers()
 {
+    if (is_offscreen()) {
+        VkFramebufferCreateInfo framebuffer_info {};
+        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_info.renderPass = m_render_pass;
+        framebuffer_info.attachmentCount = static_cast<uint32_t>(m_attachments.size());
+        framebuffer_info.pAttachments = m_attachments.data();
+        framebuffer_info.width = m_extent.width;
+        framebuffer_info.height = m_extent.height;
+        framebuffer_info.layers = 1;
+
+        m_framebuffers.resize(1);
+        VK_CHECK(vkCreateFramebuffer(m_device->get_logical_device(), &framebuffer_info, nullptr, &m_framebuffers[0]), "failed to create framebuffer");
+        return;
+    }
+
     const auto& swapchain_image_views = m_swapchain->get_image_views();
     auto *depth_view = m_swapchain->depth_image->get_view();
     uint32_t attachment_count;
@@ -120,9 +203,12 @@ void render_target::create_framebuffers()
 
 void render_target::destroy_framebuffers()
 {
-    for (auto* framebuffer : m_framebuffers) {
-        vkDestroyFramebuffer(m_device->get_logical_device(), framebuffer, nullptr);
-    }
+    m_device->defer_destroy([logical_device = m_device->get_logical_device(), framebuffers = std::move(m_framebuffers)]() {
+        for (auto* framebuffer : framebuffers) {
+            vkDestroyFramebuffer(logical_device, framebuffer, nullptr);
+        }
+    });
+    m_framebuffers.clear();
 }
 
 } // namespace quix
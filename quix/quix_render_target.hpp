@@ -32,6 +32,11 @@ struct renderpass_info {
 class render_target {
 public:
     render_target(weakref<window> p_window, weakref<device> p_device, weakref<swapchain> p_swapchain, const VkRenderPassCreateInfo* render_pass_create_info);
+    // offscreen target with a single framebuffer made from attachments, does not need a window or swapchain
+    render_target(weakref<device> p_device, const VkRenderPassCreateInfo* render_pass_create_info, std::vector<VkImageView>&& attachments, VkExtent2D extent);
+    // dynamic rendering into the swapchain, there is no render pass or framebuffer so a resize only recreates the swapchain,
+    // begin it with command_list::begin_rendering
+    render_target(weakref<window> p_window, weakref<device> p_device, weakref<swapchain> p_swapchain);
     ~render_target();
 
     render_target(const render_target&) = delete;
@@ -40,8 +45,18 @@ public:
     render_target& operator=(render_target&&) = delete;
 
     NODISCARD inline VkRenderPass get_render_pass() const noexcept { return m_render_pass; }
-    NODISCARD inline VkFramebuffer get_framebuffer(uint32_t index) const noexcept { return m_framebuffers[index]; }
+    NODISCARD inline VkFramebuffer get_framebuffer(uint32_t index) const noexcept { return m_framebuffers[is_offscreen() ? 0 : index]; }
     NODISCARD VkExtent2D get_extent() const noexcept;
+    NODISCARD inline bool is_offscreen() const noexcept { return m_swapchain.get() == nullptr; }
+    NODISCARD inline bool is_dynamic() const noexcept { return m_render_pass == VK_NULL_HANDLE; }
+
+    // dynamic targets only, the color attachment is the swapchain image and the depth attachment the swapchain's depth
+    // image if it has one, the views change when the swapchain is recreated
+    NODISCARD rendering_formats get_rendering_formats() const;
+    NODISCARD VkImage get_color_image(uint32_t image_index) const;
+    NODISCARD VkImageView get_color_view(uint32_t image_index) const;
+    NODISCARD VkImage get_depth_image() const;
+    NODISCARD VkImageView get_depth_view() const;
 
     void recreate_swapchain();
 
@@ -56,6 +71,10 @@ private:
 
     std::vector<VkFramebuffer> m_framebuffers;
     VkRenderPass m_render_pass = VK_NULL_HANDLE;
+
+    // only used by offscreen targets
+    std::vector<VkImageView> m_attachments;
+    VkExtent2D m_extent {};
 };
 
 } // namespace quix
@@ -3,9 +3,13 @@
 
 #include "quix_resource.hpp"
 
+#include "quix_asset_pack.hpp"
 #include "quix_commands.hpp"
 #include "quix_device.hpp"
 #include "quix_instance.hpp"
+#include "quix_mipmap.hpp"
+#include "quix_texture_file.hpp"
+#include "quix_upload.hpp"
 #include <vulkan/vulkan_core.h>
 
 namespace quix {
@@ -18,7 +22,9 @@ buffer_handle::buffer_handle(weakref<device> p_device)
 buffer_handle::~buffer_handle()
 {
     if (m_buffer != VK_NULL_HANDLE) {
-        vmaDestroyBuffer(m_device->get_allocator(), m_buffer, m_alloc);
+        m_device->defer_destroy([allocator = m_device->get_allocator(), buffer = m_buffer, alloc = m_alloc]() {
+            vmaDestroyBuffer(allocator, buffer, alloc);
+        });
     } else {
         spdlog::warn("buffer was never created");
     }
@@ -29,6 +35,11 @@ void buffer_handle::create_buffer(const VkBufferCreateInfo* create_info, const V
     VK_CHECK(vmaCreateBuffer(m_device->get_allocator(), create_info, alloc_info, &m_buffer, &m_alloc, &m_alloc_info), "failed to create buffer");
 }
 
+void buffer_handle::flush(VkDeviceSize offset, VkDeviceSize size)
+{
+    VK_CHECK(vmaFlushAllocation(m_device->get_allocator(), m_alloc, offset, size), "failed to flush buffer");
+}
+
 void buffer_handle::create_uniform_buffer(const VkDeviceSize size)
 {
     VkBufferCreateInfo buffer_info {};
@@ -76,32 +87,25 @@ void buffer_handle::create_gpu_buffer(const VkDeviceSize size, const VkBufferUsa
 
 void buffer_handle::create_staged_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const void* data, instance* inst)
 {
-    buffer_handle staging_buffer(m_device);
-    staging_buffer.create_staging_buffer(size);
-    memcpy(staging_buffer.get_mapped_data(), data, size);
-
-    VkBufferCreateInfo buffer_info {};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = size;
-    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage_flags;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    create_gpu_buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage_flags);
+    auto uploads = inst->get_upload_manager();
+    uploads->upload_buffer(m_buffer, 0, data, size);
+    (void)uploads->flush();
+}
 
-    VmaAllocationCreateInfo alloc_info {};
-    alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+void buffer_handle::create_staged_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const void* data, upload_batch* batch)
+{
+    create_gpu_buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage_flags);
+    batch->upload_buffer(m_buffer, 0, data, size);
+}
 
-    create_buffer(&buffer_info, &alloc_info);
+void buffer_handle::create_buffer_from_pack(const asset_pack* pack, const char* name, const VkBufferUsageFlags usage_flags, upload_batch* batch)
+{
+    const pack::entry* entry = pack->find(name);
+    quix_assert(entry != nullptr && entry->type == pack::asset_type::buffer, fmt::format("pack holds no buffer {}", name));
 
-    auto cmd_pool = inst->get_command_pool();
-    auto cmd_list = cmd_pool.create_command_list();
-
-    cmd_list->begin_record(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-    cmd_list->copy_buffer_to_buffer(staging_buffer.get_buffer(), 0, m_buffer, 0, size);
-    cmd_list->end_record();
-    VkFence fence = inst->create_fence();
-    cmd_list->submit(fence);
-    m_device->wait_idle();
-    vkWaitForFences(m_device->get_logical_device(), 1, &fence, VK_TRUE, UINT64_MAX); // hopefully no deadlocking
-    vkDestroyFence(m_device->get_logical_device(), fence, nullptr);
+    create_gpu_buffer(entry->data_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage_flags);
+    pack->read(entry, batch->reserve_buffer(m_buffer, 0, entry->data_size));
 }
 
 void buffer_handle::create_staging_buffer(const VkDeviceSize size)
@@ -131,19 +135,29 @@ image_handle::~image_handle()
 
 void image_handle::destroy_image()
 {
-    if (m_sampler != VK_NULL_HANDLE) {
-        vkDestroySampler(m_device->get_logical_device(), m_sampler, nullptr);
-    }
-
-    if (m_view != VK_NULL_HANDLE) {
-        vkDestroyImageView(m_device->get_logical_device(), m_view, nullptr);
+    // already destroyed or moved from, nothing to defer
+    if (m_image == VK_NULL_HANDLE && m_view == VK_NULL_HANDLE && m_sampler == VK_NULL_HANDLE) {
+        return;
     }
 
-    if (m_image != VK_NULL_HANDLE) {
-        vmaDestroyImage(m_device->get_allocator(), m_image, m_alloc);
-    } else {
-        spdlog::warn("image was never created");
-    }
+    // the handle can be recreated right away, the old objects go once nothing in flight can use them
+    m_device->defer_destroy([logical_device = m_device->get_logical_device(), allocator = m_device->get_allocator(),
+                                sampler = m_sampler, view = m_view, image = m_image, alloc = m_alloc]() {
+        if (sampler != VK_NULL_HANDLE) {
+            vkDestroySampler(logical_device, sampler, nullptr);
+        }
+        if (view != VK_NULL_HANDLE) {
+            vkDestroyImageView(logical_device, view, nullptr);
+        }
+        if (image != VK_NULL_HANDLE) {
+            vmaDestroyImage(allocator, image, alloc);
+        }
+    });
+
+    m_sampler = VK_NULL_HANDLE;
+    m_view = VK_NULL_HANDLE;
+    m_image = VK_NULL_HANDLE;
+    m_alloc = VK_NULL_HANDLE;
 }
 
 void image_handle::create_image(const VkImageCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info)
@@ -158,29 +172,104 @@ void image_handle::create_image(const VkImageCreateInfo* create_info, const VmaA
 }
 
 image_handle& image_handle::create_image_from_file(const char* filepath, instance* inst)
+{
+    auto uploads = inst->get_upload_manager();
+
+    if (is_texture_container(filepath)) {
+        const texture_file file = load_texture_file(filepath);
+        create_stored_image(file.format, file.extent, file.mip_levels);
+        uploads->upload_image(this, file.get_payload(), file.payload_size, file.regions.data(), static_cast<uint32_t>(file.regions.size()));
+        (void)uploads->flush();
+        return *this;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    stbi_uc* pixels = load_image_file(filepath, &width, &height);
+
+    create_rgba_image(width, height, uploads->get_mip_generator()->get_method(VK_FORMAT_R8G8B8A8_SRGB));
+    uploads->upload_image(this, pixels, VkDeviceSize { width } * height * 4);
+    uploads->generate_mips(this);
+    stbi_image_free(pixels);
+    (void)uploads->flush();
+
+    return *this;
+}
+
+image_handle& image_handle::create_image_from_file(const char* filepath, upload_batch* batch)
+{
+    if (is_texture_container(filepath)) {
+        return create_image_from_texture(load_texture_file(filepath), batch);
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    stbi_uc* pixels = load_image_file(filepath, &width, &height);
+
+    create_image_from_pixels(pixels, width, height, batch);
+    stbi_image_free(pixels);
+
+    return *this;
+}
+
+image_handle& image_handle::create_image_from_pixels(const void* pixels, uint32_t width, uint32_t height, upload_batch* batch)
+{
+    create_rgba_image(width, height, batch->get_manager()->get_mip_generator()->get_method(VK_FORMAT_R8G8B8A8_SRGB));
+    batch->upload_image(this, pixels, VkDeviceSize { width } * height * 4);
+    batch->generate_mips(this);
+
+    return *this;
+}
+
+image_handle& image_handle::create_image_from_texture(const texture_file& file, upload_batch* batch)
+{
+    create_stored_image(file.format, file.extent, file.mip_levels);
+    batch->upload_image(this, file.get_payload(), file.payload_size, file.regions.data(), static_cast<uint32_t>(file.regions.size()));
+
+    return *this;
+}
+
+image_handle& image_handle::create_image_from_pack(const asset_pack* pack, const char* name, upload_batch* batch)
+{
+    const pack::entry* entry = pack->find(name);
+    quix_assert(entry != nullptr && entry->type == pack::asset_type::texture, fmt::format("pack holds no texture {}", name));
+
+    create_stored_image(entry->format, entry->extent, entry->mip_levels);
+    pack->read(entry, batch->reserve_image(this, entry->data_size, pack->get_regions(entry), entry->region_count));
+
+    return *this;
+}
+
+NODISCARD stbi_uc* image_handle::load_image_file(const char* filepath, uint32_t* width, uint32_t* height)
 {
     int texture_width{};
     int texture_height{};
     int texture_channels{};
     stbi_uc* pixels = stbi_load(filepath, &texture_width, &texture_height, &texture_channels, STBI_rgb_alpha);
-    auto texture_size = (VkDeviceSize)(texture_width * texture_height * 4);
+    quix_assert(pixels != nullptr, fmt::format("failed to load image {}: {}", filepath, stbi_failure_reason()));
 
-    auto buffer_handle = inst->create_buffer_handle();
-    buffer_handle.create_staging_buffer(texture_size);
-    std::memcpy(buffer_handle.get_mapped_data(), pixels, texture_size);
+    *width = static_cast<uint32_t>(texture_width);
+    *height = static_cast<uint32_t>(texture_height);
+    return pixels;
+}
 
+void image_handle::create_rgba_image(uint32_t width, uint32_t height, mip_method method)
+{
     VkImageCreateInfo image_info{};
     image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     image_info.imageType = VK_IMAGE_TYPE_2D;
-    image_info.extent.width = texture_width;
-    image_info.extent.height = texture_height;
+    image_info.extent.width = width;
+    image_info.extent.height = height;
     image_info.extent.depth = 1;
-    image_info.mipLevels = 1;
+    image_info.mipLevels = method == mip_method::none ? 1 : get_full_mip_count(image_info.extent);
     image_info.arrayLayers = 1;
     image_info.format = VK_FORMAT_R8G8B8A8_SRGB;
     image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
     image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     image_info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (method == mip_method::compute) {
+        image_info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
     image_info.samples = VK_SAMPLE_COUNT_1_BIT;
     image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -189,46 +278,67 @@ image_handle& image_handle::create_image_from_file(const char* filepath, instanc
     alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
     create_image(&image_info, &alloc_info);
+}
 
-    auto cmd_pool = inst->get_command_pool();
-    auto cmd_list = cmd_pool.create_command_list();
-
-    cmd_list->begin_record(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+void image_handle::create_stored_image(VkFormat format, VkExtent3D extent, uint32_t mip_levels)
+{
+    const bool block_compressed = format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    quix_assert(!block_compressed || m_device->get_enabled_features().core.features.textureCompressionBC == VK_TRUE,
+        "bc textures need the textureCompressionBC feature");
 
-    image_barrier_info barrier_info{};
-    barrier_info.src_access_mask = 0;
-    barrier_info.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier_info.src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    barrier_info.dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    barrier_info.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier_info.new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_device->get_physical_device(), format, &properties);
+    constexpr VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    quix_assert((properties.optimalTilingFeatures & required_features) == required_features,
+        fmt::format("texture format {} is not supported", static_cast<int>(format)));
 
-    cmd_list->image_barrier(this, &barrier_info);
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent = extent;
+    image_info.mipLevels = mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    cmd_list->copy_buffer_to_image(buffer_handle.get_buffer(), 0, this, {0, 0, 0});
+    VmaAllocationCreateInfo alloc_info{};
+    alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    barrier_info.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier_info.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
-    barrier_info.src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    barrier_info.dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    barrier_info.old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier_info.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    create_image(&image_info, &alloc_info);
+}
 
-    cmd_list->image_barrier(this, &barrier_info);
-    
-    cmd_list->end_record();
+image_handle& image_handle::create_depth_image(uint32_t width, uint32_t height, VkFormat format)
+{
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = width;
+    image_info.extent.height = height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    VkFence fence = inst->create_fence();
-    cmd_list->submit(fence);
-    vkWaitForFences(m_device->get_logical_device(), 1, &fence, VK_TRUE, UINT64_MAX); // hopefully no deadlocking
-    vkDestroyFence(m_device->get_logical_device(), fence, nullptr);
+    VmaAllocationCreateInfo alloc_info{};
+    alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    stbi_image_free(pixels);
+    create_image(&image_info, &alloc_info);
 
     return *this;
 }
 
-image_handle& image_handle::create_depth_image(uint32_t width, uint32_t height, VkFormat format)
+image_handle& image_handle::create_color_image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags extra_usage)
 {
     VkImageCreateInfo image_info{};
     image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -241,7 +351,7 @@ image_handle& image_handle::create_depth_image(uint32_t width, uint32_t height,
     image_info.format = format;
     image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
     image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | extra_usage;
     image_info.samples = VK_SAMPLE_COUNT_1_BIT;
     image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -311,7 +421,8 @@ image_handle& image_handle::create_sampler(VkFilter m_filter, VkSamplerAddressMo
     sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     sampler_info.mipLodBias = 0.0f;
     sampler_info.minLod = 0.0f;
-    sampler_info.maxLod = VK_LOD_CLAMP_NONE; //IDK MAN I THINK THIS IS RIGHT
+    // the whole mip chain of the image, create the sampler after the image
+    sampler_info.maxLod = static_cast<float>(m_mip_levels);
 
     VK_CHECK(vkCreateSampler(m_device->get_logical_device(), &sampler_info, nullptr, &m_sampler), "failed to create sampler");
 
@@ -334,7 +445,8 @@ image_handle& image_handle::create_sampler(VkFilter m_filter, VkSamplerAddressMo
     sampler_info.addressModeV = sampler_address_mode;
     sampler_info.addressModeW = sampler_address_mode;
 
-    sampler_info.anisotropyEnable = VK_TRUE;
+    // anisotropic filtering is only valid when the device was created with samplerAnisotropy
+    sampler_info.anisotropyEnable = m_device->get_enabled_features().core.features.samplerAnisotropy;
     float max_anisotrophy = m_device->get_max_sampler_anisotropy();
 
     if (anisotropy > max_anisotrophy) {
@@ -343,7 +455,7 @@ image_handle& image_handle::create_sampler(VkFilter m_filter, VkSamplerAddressMo
     if (anisotropy == 0.0f) {
         anisotropy = max_anisotrophy;
     }
-    sampler_info.maxAnisotropy = anisotropy;
+    sampler_info.maxAnisotropy = sampler_info.anisotropyEnable == VK_TRUE ? anisotropy : 1.0f;
 
     // beyond image clamp
     sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -359,7 +471,8 @@ image_handle& image_handle::create_sampler(VkFilter m_filter, VkSamplerAddressMo
     sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     sampler_info.mipLodBias = 0.0f;
     sampler_info.minLod = 0.0f;
-    sampler_info.maxLod = VK_LOD_CLAMP_NONE; //IDK MAN I THINK THIS IS RIGHT
+    // the whole mip chain of the image, create the sampler after the image
+    sampler_info.maxLod = static_cast<float>(m_mip_levels);
 
     VK_CHECK(vkCreateSampler(m_device->get_logical_device(), &sampler_info, nullptr, &m_sampler), "failed to create sampler");
 
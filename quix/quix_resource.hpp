@@ -6,6 +6,10 @@ namespace quix {
 class device;
 class instance;
 class command_list;
+class upload_batch;
+enum class mip_method;
+struct texture_file;
+class asset_pack;
 
 class buffer_handle {
 public:
@@ -22,7 +26,13 @@ public:
     void create_staging_buffer(const VkDeviceSize size);
     void create_cpu_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const VmaAllocationCreateFlags alloc_flags);
     void create_gpu_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags);
+    // submitted right away through the instance's upload manager, graphics submissions made afterwards see the data,
+    // loading many assets is cheaper with an upload_batch
     void create_staged_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const void* data, instance* inst);
+    // queued on batch, usable once the batch is submitted
+    void create_staged_buffer(const VkDeviceSize size, const VkBufferUsageFlags usage_flags, const void* data, upload_batch* batch);
+    // the asset is copied from the pack straight into staging memory
+    void create_buffer_from_pack(const asset_pack* pack, const char* name, const VkBufferUsageFlags usage_flags, upload_batch* batch);
 
     NODISCARD inline VkBuffer get_buffer() const noexcept { return m_buffer; }
     NODISCARD inline VmaAllocationInfo get_alloc_info() const noexcept { return m_alloc_info; }
@@ -32,6 +42,8 @@ public:
         return m_alloc_info.pMappedData;
     }
     NODISCARD inline VkDeviceSize get_offset() const noexcept { return m_alloc_info.offset; }
+    // makes host writes visible to the device when the memory is not host coherent, a no-op otherwise
+    void flush(VkDeviceSize offset, VkDeviceSize size);
     NODISCARD inline VkDescriptorBufferInfo get_descriptor_info(uint32_t offset = 0)
     {
         VkDescriptorBufferInfo info {};
@@ -62,8 +74,19 @@ public:
 
     void create_image(const VkImageCreateInfo* create_info, const VmaAllocationCreateInfo* alloc_info);
 
+    // submitted right away through the instance's upload manager like create_staged_buffer
+    // the full mip chain is generated on the gpu when the format allows it, ktx2 and dds files keep their stored
+    // format and mip chain and are copied without decoding
     image_handle& create_image_from_file(const char* filepath, instance* inst);
+    image_handle& create_image_from_file(const char* filepath, upload_batch* batch);
+    // pixels are tightly packed rgba8 and may be freed on return, used by the texture loader once decoding is done
+    image_handle& create_image_from_pixels(const void* pixels, uint32_t width, uint32_t height, upload_batch* batch);
+    image_handle& create_image_from_texture(const texture_file& file, upload_batch* batch);
+    // the stored mip chain is copied from the pack straight into staging memory
+    image_handle& create_image_from_pack(const asset_pack* pack, const char* name, upload_batch* batch);
     image_handle& create_depth_image(uint32_t width, uint32_t height, VkFormat format);
+    // color attachment for offscreen render targets, extra_usage is usually VK_IMAGE_USAGE_TRANSFER_SRC_BIT for readback
+    image_handle& create_color_image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags extra_usage = 0);
 
     image_handle& create_view(VkImageAspectFlags aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT);
     image_handle& create_sampler(VkFilter m_filter, VkSamplerAddressMode sampler_address_mode);
@@ -72,6 +95,10 @@ public:
     NODISCARD inline VkImage get_image() const noexcept { return m_image; }
     NODISCARD inline VkImageView get_view() const noexcept { return m_view; }
     NODISCARD inline VkSampler get_sampler() const noexcept { return m_sampler; }
+    NODISCARD inline VkFormat get_format() const noexcept { return m_format; }
+    NODISCARD inline VkExtent3D get_extent() const noexcept { return m_extent; }
+    NODISCARD inline uint32_t get_mip_levels() const noexcept { return m_mip_levels; }
+    NODISCARD inline uint32_t get_array_layers() const noexcept { return m_array_layers; }
 
     NODISCARD inline VkDescriptorImageInfo get_descriptor_info()
     {
@@ -86,6 +113,11 @@ public:
 
 private:
     constexpr VkImageViewType type_to_view_type();
+    // decodes to rgba8, the pixels are freed by the caller
+    NODISCARD stbi_uc* load_image_file(const char* filepath, uint32_t* width, uint32_t* height);
+    void create_rgba_image(uint32_t width, uint32_t height, mip_method method);
+    // creates an image for a format and mip chain stored in a file, ktx2, dds or a pack, whose data is copied as it is
+    void create_stored_image(VkFormat format, VkExtent3D extent, uint32_t mip_levels);
 
     weakref<device> m_device;
     VmaAllocation m_alloc {};
@@ -56,6 +56,12 @@ shader::shader(const char* path, EShLanguage stage)
     spdlog::trace("Shader created from {}", path);
 }
 
+shader::shader(const char* name, const char* source, EShLanguage stage)
+{
+    spdlog::trace("Creating shader {} from source", name);
+    compileSource(stage, name, source);
+}
+
 std::vector<uint32_t>& shader::getSpirvCode()
 {
     return code;
@@ -131,6 +137,15 @@ void shader::setShaderVersion(uint32_t apiVersion)
 }
 
 void shader::compileShader(EShLanguage stage, const char* path, const char* cSpvPath)
+{
+    std::string source = getSourceCode(path);
+    compileSource(stage, path, source.c_str());
+
+    // save the spv code to a file
+    saveSpvCode(cSpvPath);
+}
+
+void shader::compileSource(EShLanguage stage, const char* path, const char* cSource)
 {
     spdlog::trace("Compiling shader {}", path);
     const TBuiltInResource* resources = GetDefaultResources();
@@ -142,8 +157,6 @@ void shader::compileShader(EShLanguage stage, const char* path, const char* cSpv
     shader.setEnvClient(glslang::EShClientVulkan, eshTargetClientVersion);
     shader.setEnvTarget(glslang::EShTargetSpv, eshTargetLanguageVersion);
 
-    std::string source = getSourceCode(path);
-    const char* cSource = source.c_str();
     shader.setStrings(&cSource, 1);
 
     quix_assert(shader.parse(resources, 100, false, EShMsgDefault), fmt::format("Error in {} {}", path, shader.getInfoLog()));
@@ -203,9 +216,6 @@ void shader::compileShader(EShLanguage stage, const char* path, const char* cSpv
     //
     // bool validationResult = core.Validate(code);
     // quix_assert(validationResult == true, fmt::format("error in {}", path));
-
-    // save the spv code to a file
-    saveSpvCode(cSpvPath);
 }
 
 const std::string shader::getSourceCode(const char* path)
@@ -6,6 +6,8 @@ namespace quix {
 class shader {
 public:
     shader(const char* path, EShLanguage stage);
+    // compiles glsl embedded in the library, nothing is cached on disk
+    shader(const char* name, const char* source, EShLanguage stage);
     ~shader() = default;
 
     shader(const shader&) = delete;
@@ -20,6 +22,7 @@ public:
 
 private:
     void compileShader(EShLanguage stage, const char* path, const char* cSpvPath);
+    void compileSource(EShLanguage stage, const char* name, const char* source);
     const std::string getSourceCode(const char* path);
     void loadSpvCode(const char* path);
     void saveSpvCode(const char* path);
@@ -32,14 +32,19 @@ swapchain::~swapchain()
 void swapchain::recreate_swapchain()
 {
     VkSwapchainKHR old_swapchain = m_swapchain;
+    std::vector<VkImageView> old_image_views = std::move(m_swapchain_image_views);
     m_swapchain_images.clear();
-    create_swapchain(old_swapchain);
-
-    destroy_image_views();
     m_swapchain_image_views.clear();
+    create_swapchain(old_swapchain);
 
     create_image_views();
 
+    // presents are not tracked by any timeline, so defer_destroy cannot tell when the old images are free, only an
+    // idle device guarantees no present of them is still pending
+    m_device->wait_idle();
+    for (auto* image_view : old_image_views) {
+        vkDestroyImageView(m_device->get_logical_device(), image_view, nullptr);
+    }
     vkDestroySwapchainKHR(m_device->get_logical_device(), old_swapchain, nullptr);
 }
 
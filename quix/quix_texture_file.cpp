@@ -0,0 +1,332 @@
+#ifndef _QUIX_TEXTURE_FILE_CPP
+#define _QUIX_TEXTURE_FILE_CPP
+
+#include "quix_texture_file.hpp"
+
+#include "quix_mipmap.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+namespace quix {
+
+namespace {
+
+    constexpr std::array<unsigned char, 12> ktx2_identifier = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr std::size_t ktx2_header_size = 80;
+    constexpr std::size_t ktx2_level_size = 24;
+
+    constexpr uint32_t make_four_cc(char a, char b, char c, char d) noexcept
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    constexpr uint32_t dds_magic = make_four_cc('D', 'D', 'S', ' ');
+    constexpr std::size_t dds_header_size = 128;
+    constexpr std::size_t dds_dx10_header_size = 20;
+    constexpr uint32_t dds_cubemap_flag = 0x200;
+    constexpr uint32_t dds_volume_flag = 0x200000;
+    constexpr uint32_t dxgi_dimension_texture2d = 3;
+
+    template <typename Type>
+    NODISCARD Type read_value(const std::vector<char>& contents, std::size_t offset)
+    {
+        quix_assert(offset + sizeof(Type) <= contents.size(), "texture file is truncated");
+
+        Type value {};
+        std::memcpy(&value, contents.data() + offset, sizeof(Type));
+        return value;
+    }
+
+    // bytes per 4x4 block, 0 for anything that is not block compressed
+    NODISCARD constexpr VkDeviceSize get_block_size(VkFormat format) noexcept
+    {
+        switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    // bytes per texel of the uncompressed formats ktx2 files are accepted in, 0 for anything else
+    NODISCARD constexpr VkDeviceSize get_texel_size(VkFormat format) noexcept
+    {
+        switch (format) {
+        case VK_FORMAT_R8_UNORM:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R16_SFLOAT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    // block compressed levels round up to whole 4x4 blocks
+    NODISCARD VkDeviceSize get_level_size(VkFormat format, VkExtent3D extent) noexcept
+    {
+        const VkDeviceSize block_size = get_block_size(format);
+        if (block_size != 0) {
+            return VkDeviceSize { (extent.width + 3) / 4 } * ((extent.height + 3) / 4) * block_size;
+        }
+        return VkDeviceSize { extent.width } * extent.height * get_texel_size(format);
+    }
+
+    NODISCARD VkFormat dds_four_cc_to_format(uint32_t four_cc) noexcept
+    {
+        switch (four_cc) {
+        case make_four_cc('D', 'X', 'T', '1'):
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case make_four_cc('D', 'X', 'T', '2'):
+        case make_four_cc('D', 'X', 'T', '3'):
+            return VK_FORMAT_BC2_UNORM_BLOCK;
+        case make_four_cc('D', 'X', 'T', '4'):
+        case make_four_cc('D', 'X', 'T', '5'):
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case make_four_cc('A', 'T', 'I', '1'):
+        case make_four_cc('B', 'C', '4', 'U'):
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case make_four_cc('B', 'C', '4', 'S'):
+            return VK_FORMAT_BC4_SNORM_BLOCK;
+        case make_four_cc('A', 'T', 'I', '2'):
+        case make_four_cc('B', 'C', '5', 'U'):
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case make_four_cc('B', 'C', '5', 'S'):
+            return VK_FORMAT_BC5_SNORM_BLOCK;
+        default:
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // typeless formats are read as unorm
+    NODISCARD VkFormat dxgi_to_format(uint32_t dxgi_format) noexcept
+    {
+        switch (dxgi_format) {
+        case 70: // DXGI_FORMAT_BC1_TYPELESS
+        case 71: // DXGI_FORMAT_BC1_UNORM
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+            return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 73: // DXGI_FORMAT_BC2_TYPELESS
+        case 74: // DXGI_FORMAT_BC2_UNORM
+            return VK_FORMAT_BC2_UNORM_BLOCK;
+        case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+            return VK_FORMAT_BC2_SRGB_BLOCK;
+        case 76: // DXGI_FORMAT_BC3_TYPELESS
+        case 77: // DXGI_FORMAT_BC3_UNORM
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+            return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 79: // DXGI_FORMAT_BC4_TYPELESS
+        case 80: // DXGI_FORMAT_BC4_UNORM
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case 81: // DXGI_FORMAT_BC4_SNORM
+            return VK_FORMAT_BC4_SNORM_BLOCK;
+        case 82: // DXGI_FORMAT_BC5_TYPELESS
+        case 83: // DXGI_FORMAT_BC5_UNORM
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 84: // DXGI_FORMAT_BC5_SNORM
+            return VK_FORMAT_BC5_SNORM_BLOCK;
+        case 94: // DXGI_FORMAT_BC6H_TYPELESS
+        case 95: // DXGI_FORMAT_BC6H_UF16
+            return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        case 96: // DXGI_FORMAT_BC6H_SF16
+            return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+        case 97: // DXGI_FORMAT_BC7_TYPELESS
+        case 98: // DXGI_FORMAT_BC7_UNORM
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        default:
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    NODISCARD VkBufferImageCopy make_level_region(const texture_file& file, uint32_t level, VkDeviceSize offset) noexcept
+    {
+        VkBufferImageCopy region {};
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent.width = std::max(file.extent.width >> level, 1u);
+        region.imageExtent.height = std::max(file.extent.height >> level, 1u);
+        region.imageExtent.depth = 1;
+        return region;
+    }
+
+    void parse_ktx2(texture_file& file)
+    {
+        const auto& contents = file.contents;
+
+        const auto format = static_cast<VkFormat>(read_value<uint32_t>(contents, 12));
+        const auto width = read_value<uint32_t>(contents, 20);
+        const auto height = read_value<uint32_t>(contents, 24);
+        const auto depth = read_value<uint32_t>(contents, 28);
+        const auto layer_count = read_value<uint32_t>(contents, 32);
+        const auto face_count = read_value<uint32_t>(contents, 36);
+        const auto level_count = read_value<uint32_t>(contents, 40);
+        const auto supercompression = read_value<uint32_t>(contents, 44);
+
+        quix_assert(format != VK_FORMAT_UNDEFINED, "ktx2 files with basis universal payloads are not supported");
+        quix_assert(get_block_size(format) != 0 || get_texel_size(format) != 0, "ktx2 file format is not supported");
+        quix_assert(supercompression == 0, "supercompressed ktx2 files are not supported");
+        quix_assert(width != 0 && height != 0 && depth <= 1, "only 2d ktx2 textures are supported");
+        quix_assert(layer_count <= 1 && face_count == 1, "ktx2 arrays and cube maps are not supported");
+
+        file.format = format;
+        file.extent = { width, height, 1 };
+        quix_assert(level_count != 0, "ktx2 files that ask for generated mips are not supported");
+        quix_assert(level_count <= get_full_mip_count(file.extent), "ktx2 file has more levels than its extent allows");
+        file.mip_levels = level_count;
+
+        VkDeviceSize payload_begin = std::numeric_limits<VkDeviceSize>::max();
+        VkDeviceSize payload_end = 0;
+        for (uint32_t level = 0; level < file.mip_levels; level++) {
+            const std::size_t entry = ktx2_header_size + level * ktx2_level_size;
+            const auto offset = read_value<uint64_t>(contents, entry);
+            const auto length = read_value<uint64_t>(contents, entry + 8);
+            quix_assert(length <= contents.size() && offset <= contents.size() - length, "ktx2 level points past the end of the file");
+
+            const VkBufferImageCopy region = make_level_region(file, level, offset);
+            quix_assert(length >= get_level_size(format, region.imageExtent), "ktx2 level is smaller than its extent needs");
+
+            payload_begin = std::min(payload_begin, offset);
+            payload_end = std::max(payload_end, offset + length);
+            file.regions.push_back(region);
+        }
+
+        file.payload_offset = payload_begin;
+        file.payload_size = payload_end - payload_begin;
+        for (auto& region : file.regions) {
+            region.bufferOffset -= payload_begin;
+        }
+    }
+
+    void parse_dds(texture_file& file)
+    {
+        const auto& contents = file.contents;
+
+        const auto height = read_value<uint32_t>(contents, 12);
+        const auto width = read_value<uint32_t>(contents, 16);
+        const auto mip_count = read_value<uint32_t>(contents, 28);
+        const auto four_cc = read_value<uint32_t>(contents, 84);
+        const auto caps2 = read_value<uint32_t>(contents, 112);
+
+        quix_assert((caps2 & (dds_cubemap_flag | dds_volume_flag)) == 0, "dds cube maps and volume textures are not supported");
+        quix_assert(width != 0 && height != 0, "dds file has an empty extent");
+
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        std::size_t payload_offset = dds_header_size;
+        if (four_cc == make_four_cc('D', 'X', '1', '0')) {
+            const auto dxgi_format = read_value<uint32_t>(contents, dds_header_size);
+            const auto dimension = read_value<uint32_t>(contents, dds_header_size + 4);
+            const auto array_size = read_value<uint32_t>(contents, dds_header_size + 12);
+            quix_assert(dimension == dxgi_dimension_texture2d && array_size <= 1, "only single layer 2d dds textures are supported");
+
+            format = dxgi_to_format(dxgi_format);
+            payload_offset += dds_dx10_header_size;
+        } else {
+            format = dds_four_cc_to_format(four_cc);
+        }
+        quix_assert(format != VK_FORMAT_UNDEFINED, "dds file does not hold bc1 to bc7 blocks");
+
+        file.format = format;
+        file.extent = { width, height, 1 };
+        file.mip_levels = std::max(mip_count, 1u);
+        quix_assert(file.mip_levels <= get_full_mip_count(file.extent), "dds file has more levels than its extent allows");
+        file.payload_offset = payload_offset;
+
+        // dds levels are stored back to back from the largest, every level rounds up to whole blocks
+        VkDeviceSize offset = 0;
+        for (uint32_t level = 0; level < file.mip_levels; level++) {
+            const VkBufferImageCopy region = make_level_region(file, level, offset);
+            file.regions.push_back(region);
+            offset += get_level_size(format, region.imageExtent);
+        }
+
+        quix_assert(payload_offset <= contents.size() && offset <= contents.size() - payload_offset, "dds file is truncated");
+        file.payload_size = offset;
+    }
+
+} // namespace
+
+NODISCARD bool is_texture_container(const char* filepath) noexcept
+{
+    std::string extension = std::filesystem::path(filepath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return extension == ".ktx2" || extension == ".dds";
+}
+
+NODISCARD std::vector<char> read_texture_bytes(const char* filepath)
+{
+    FILE* handle = fopen(filepath, "rb");
+    quix_assert(handle != nullptr, fmt::format("failed to open texture file {}", filepath));
+
+    (void)fseek(handle, 0, SEEK_END);
+    const auto file_size = static_cast<std::size_t>(ftell(handle));
+    (void)fseek(handle, 0, SEEK_SET);
+
+    std::vector<char> contents(file_size);
+    const std::size_t read_size = fread(contents.data(), 1, file_size, handle);
+    (void)fclose(handle);
+
+    quix_assert(read_size == file_size, fmt::format("failed to read texture file {}", filepath));
+    return contents;
+}
+
+NODISCARD texture_file load_texture_file(const char* filepath)
+{
+    return parse_texture_file(filepath, read_texture_bytes(filepath));
+}
+
+NODISCARD texture_file parse_texture_file(const char* filepath, std::vector<char>&& contents)
+{
+    texture_file file {};
+    file.contents = std::move(contents);
+
+    if (file.contents.size() >= ktx2_identifier.size() && std::memcmp(file.contents.data(), ktx2_identifier.data(), ktx2_identifier.size()) == 0) {
+        parse_ktx2(file);
+    } else if (read_value<uint32_t>(file.contents, 0) == dds_magic) {
+        parse_dds(file);
+    } else {
+        quix_error(fmt::format("{} is neither a ktx2 nor a dds file", filepath));
+    }
+
+    return file;
+}
+
+} // namespace quix
+
+#endif // _QUIX_TEXTURE_FILE_CPP
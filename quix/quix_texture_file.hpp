@@ -0,0 +1,33 @@
+#ifndef _QUIX_TEXTURE_FILE_HPP
+#define _QUIX_TEXTURE_FILE_HPP
+
+namespace quix {
+
+// a texture container whose payload is uploaded exactly as it is stored, regions address every mip level
+// relative to the start of the payload so the whole chain goes out with one vkCmdCopyBufferToImage
+struct texture_file {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent3D extent {};
+    uint32_t mip_levels = 0;
+
+    std::vector<char> contents {};
+    VkDeviceSize payload_offset = 0;
+    VkDeviceSize payload_size = 0;
+    std::vector<VkBufferImageCopy> regions {};
+
+    NODISCARD inline const char* get_payload() const noexcept { return contents.data() + payload_offset; }
+};
+
+// ktx2 and dds files are recognized by their extension, anything else goes through stb
+NODISCARD bool is_texture_container(const char* filepath) noexcept;
+
+// single layer 2d textures only, ktx2 files must store every level they use without supercompression in bc1 to bc7
+// or a common 8, 16 or 32 bit per channel format, dds files must hold bc1 to bc7 blocks
+NODISCARD texture_file load_texture_file(const char* filepath);
+// load_texture_file split in two so reading and parsing can happen on different threads
+NODISCARD std::vector<char> read_texture_bytes(const char* filepath);
+NODISCARD texture_file parse_texture_file(const char* filepath, std::vector<char>&& contents);
+
+} // namespace quix
+
+#endif // _QUIX_TEXTURE_FILE_HPP
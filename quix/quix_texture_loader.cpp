@@ -0,0 +1,125 @@
+#ifndef _QUIX_TEXTURE_LOADER_CPP
+#define _QUIX_TEXTURE_LOADER_CPP
+
+#include "quix_texture_loader.hpp"
+
+#include "quix_jobs.hpp"
+#include "quix_resource.hpp"
+#include "quix_texture_file.hpp"
+#include "quix_upload.hpp"
+
+namespace quix {
+
+namespace {
+
+    // stb pixels for plain images, the parsed file for ktx2 and dds containers
+    struct decoded_texture {
+        uint32_t index = 0;
+        stbi_uc* pixels = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        texture_file file {};
+    };
+
+    struct load_state {
+        std::mutex mutex;
+        std::condition_variable ready_condition;
+        std::deque<decoded_texture> ready {};
+        job_counter counter {};
+    };
+
+    NODISCARD decoded_texture decode(const char* filepath, uint32_t index, std::vector<char>&& contents)
+    {
+        decoded_texture texture {};
+        texture.index = index;
+
+        if (is_texture_container(filepath)) {
+            texture.file = parse_texture_file(filepath, std::move(contents));
+            return texture;
+        }
+
+        int width {};
+        int height {};
+        int channels {};
+        texture.pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(contents.data()), static_cast<int>(contents.size()),
+            &width, &height, &channels, STBI_rgb_alpha);
+        quix_assert(texture.pixels != nullptr, fmt::format("failed to decode image {}: {}", filepath, stbi_failure_reason()));
+
+        texture.width = static_cast<uint32_t>(width);
+        texture.height = static_cast<uint32_t>(height);
+        return texture;
+    }
+
+} // namespace
+
+texture_loader::texture_loader(weakref<job_system> p_jobs, weakref<upload_manager> p_uploads, uint32_t max_in_flight, VkDeviceSize submit_size)
+    : m_jobs(std::move(p_jobs))
+    , m_uploads(std::move(p_uploads))
+    , m_max_in_flight(std::max(max_in_flight, 1u))
+    , m_submit_size(submit_size != 0 ? submit_size : m_uploads->get_ring_size() / 4)
+{
+}
+
+timeline_point texture_loader::load(const char* const* paths, image_handle* images, uint32_t count)
+{
+    load_state state {};
+    job_system* jobs = m_jobs.get();
+
+    upload_batch batch = m_uploads->create_batch();
+    VkDeviceSize staged_size = 0;
+
+    uint32_t next = 0;
+    uint32_t in_flight = 0;
+    for (uint32_t finished = 0; finished < count; finished++) {
+        // stage one reads a file and hands it to stage two, which decodes it on whichever worker picks it up
+        for (; next < count && in_flight < m_max_in_flight; next++, in_flight++) {
+            auto read = [&state, jobs, filepath = paths[next], index = next]() {
+                auto decode_job = [&state, filepath, index, contents = read_texture_bytes(filepath)]() mutable {
+                    decoded_texture texture = decode(filepath, index, std::move(contents));
+                    {
+                        std::lock_guard<std::mutex> lock(state.mutex);
+                        state.ready.push_back(std::move(texture));
+                    }
+                    state.ready_condition.notify_one();
+                };
+                jobs->schedule(std::move(decode_job), &state.counter);
+            };
+            jobs->schedule(std::move(read), &state.counter);
+        }
+
+        decoded_texture texture {};
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.ready_condition.wait(lock, [&state]() { return !state.ready.empty(); });
+            texture = std::move(state.ready.front());
+            state.ready.pop_front();
+        }
+        in_flight--;
+
+        // stage three creates the image and copies the decoded data into staging memory
+        image_handle* image = images + texture.index;
+        if (texture.pixels != nullptr) {
+            image->create_image_from_pixels(texture.pixels, texture.width, texture.height, &batch);
+            staged_size += VkDeviceSize { texture.width } * texture.height * 4;
+            stbi_image_free(texture.pixels);
+        } else {
+            image->create_image_from_texture(texture.file, &batch);
+            staged_size += texture.file.payload_size;
+        }
+
+        // stage four records the copies of everything staged so far, submitting often lets the ring be reused
+        if (staged_size >= m_submit_size) {
+            batch.submit();
+            staged_size = 0;
+        }
+    }
+
+    // every result has been consumed, this only waits for the jobs to let go of the counter
+    jobs->wait(&state.counter);
+
+    return batch.submit();
+}
+
+} // namespace quix
+
+#endif // _QUIX_TEXTURE_LOADER_CPP
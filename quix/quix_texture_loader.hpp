@@ -0,0 +1,40 @@
+#ifndef _QUIX_TEXTURE_LOADER_HPP
+#define _QUIX_TEXTURE_LOADER_HPP
+
+namespace quix {
+
+class job_system;
+class upload_manager;
+class image_handle;
+
+// loads many textures through four overlapping stages, files are read and decoded as jobs while the calling thread
+// creates the images, copies the results into staging memory and submits them in batches, at most max_in_flight
+// files are held between being read and being staged which caps the memory used by read and decoded data
+class texture_loader {
+public:
+    static constexpr uint32_t default_max_in_flight = 64;
+
+    // submit_size 0 submits whenever a quarter of the upload ring has been staged
+    texture_loader(weakref<job_system> p_jobs, weakref<upload_manager> p_uploads, uint32_t max_in_flight = default_max_in_flight, VkDeviceSize submit_size = 0);
+
+    texture_loader(const texture_loader&) = delete;
+    texture_loader& operator=(const texture_loader&) = delete;
+    texture_loader(texture_loader&&) = delete;
+    texture_loader& operator=(texture_loader&&) = delete;
+
+    // fills images[i] from paths[i] like create_image_from_file, the images must stay in place until this returns and
+    // graphics submissions made afterwards see their contents, must not be called from a job
+    timeline_point load(const char* const* paths, image_handle* images, uint32_t count);
+
+    NODISCARD inline uint32_t get_max_in_flight() const noexcept { return m_max_in_flight; }
+
+private:
+    weakref<job_system> m_jobs;
+    weakref<upload_manager> m_uploads;
+    uint32_t m_max_in_flight;
+    VkDeviceSize m_submit_size;
+};
+
+} // namespace quix
+
+#endif // _QUIX_TEXTURE_LOADER_HPP
@@ -0,0 +1,446 @@
+#ifndef _QUIX_UPLOAD_CPP
+#define _QUIX_UPLOAD_CPP
+
+#include "quix_upload.hpp"
+
+#include "quix_commands.hpp"
+#include "quix_device.hpp"
+
+namespace quix {
+
+upload_batch::upload_batch(weakref<upload_manager> p_manager)
+    : m_manager(std::move(p_manager))
+    , m_id(m_manager->next_batch_id())
+{
+}
+
+upload_batch::~upload_batch()
+{
+    // ring regions of this batch would otherwise never be handed back
+    submit();
+}
+
+void upload_batch::upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    std::memcpy(reserve_buffer(dst, dst_offset, size), data, size);
+}
+
+void upload_batch::upload_image(image_handle* dst, const void* data, VkDeviceSize size, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    if (size == 0) {
+        return;
+    }
+
+    std::memcpy(reserve_image(dst, size, regions, region_count), data, size);
+}
+
+NODISCARD void* upload_batch::reserve_buffer(VkBuffer dst, VkDeviceSize dst_offset, VkDeviceSize size)
+{
+    quix_assert(size != 0, "cannot reserve an empty upload");
+
+    const staging_range staging = stage(size);
+
+    VkBufferCopy region {};
+    region.srcOffset = staging.offset;
+    region.dstOffset = dst_offset;
+    region.size = size;
+
+    m_buffer_copies.push_back(pending_buffer_copy { staging.buffer, dst, region });
+    return staging.mapped;
+}
+
+NODISCARD void* upload_batch::reserve_image(image_handle* dst, VkDeviceSize size, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    quix_assert(size != 0, "cannot reserve an empty upload");
+
+    const staging_range staging = stage(size);
+    track_image(dst);
+
+    if (regions == nullptr) {
+        VkBufferImageCopy region {};
+        region.bufferOffset = staging.offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = dst->get_array_layers();
+        region.imageExtent = dst->get_extent();
+
+        m_image_copies.push_back(pending_image_copy { staging.buffer, dst->get_image(), region });
+        return staging.mapped;
+    }
+
+    for (uint32_t i = 0; i < region_count; i++) {
+        VkBufferImageCopy region = regions[i];
+        region.bufferOffset += staging.offset;
+
+        m_image_copies.push_back(pending_image_copy { staging.buffer, dst->get_image(), region });
+    }
+    return staging.mapped;
+}
+
+void upload_batch::generate_mips(image_handle* dst)
+{
+    const auto pending = std::find_if(m_images.begin(), m_images.end(), [dst](const pending_image& image) {
+        return image.image.image == dst->get_image();
+    });
+    quix_assert(pending != m_images.end(), "mips can only be generated for an image uploaded in the same batch");
+
+    if (pending->image.mip_levels > 1) {
+        pending->generate_mips = true;
+    }
+}
+
+void upload_batch::track_image(const image_handle* dst)
+{
+    const bool tracked = std::any_of(m_images.begin(), m_images.end(), [dst](const pending_image& image) {
+        return image.image.image == dst->get_image();
+    });
+    if (tracked) {
+        return;
+    }
+
+    mip_image image {};
+    image.image = dst->get_image();
+    image.format = dst->get_format();
+    image.extent = dst->get_extent();
+    image.mip_levels = dst->get_mip_levels();
+    image.array_layers = dst->get_array_layers();
+    m_images.push_back(pending_image { image, false });
+}
+
+NODISCARD upload_batch::staging_range upload_batch::stage(VkDeviceSize size)
+{
+    VkDeviceSize offset = 0;
+    if (m_manager->allocate(size, m_id, &offset)) {
+        return staging_range { m_manager->m_ring.get_buffer(), offset, static_cast<char*>(m_manager->m_ring.get_mapped_data()) + offset };
+    }
+
+    // the ring is exhausted, a staging buffer of its own keeps this upload from waiting on the gpu
+    auto& staging = m_dedicated_staging.emplace_back(std::make_unique<buffer_handle>(m_manager->m_device));
+    staging->create_staging_buffer(size);
+
+    return staging_range { staging->get_buffer(), 0, staging->get_mapped_data() };
+}
+
+timeline_point upload_batch::submit()
+{
+    if (empty()) {
+        return m_last_submit;
+    }
+
+    const weakref<device>& p_device = m_manager->m_device;
+    const bool dedicated_transfer = p_device->has_dedicated_queue(queue_type::transfer);
+
+    // grouping by destination lets every destination get one copy command, sorted offsets let back to back ranges share a barrier
+    std::sort(m_buffer_copies.begin(), m_buffer_copies.end(), [](const pending_buffer_copy& a, const pending_buffer_copy& b) {
+        return std::tie(a.dst, a.src, a.region.dstOffset) < std::tie(b.dst, b.src, b.region.dstOffset);
+    });
+    std::stable_sort(m_image_copies.begin(), m_image_copies.end(), [](const pending_image_copy& a, const pending_image_copy& b) {
+        return std::tie(a.dst, a.src) < std::tie(b.dst, b.src);
+    });
+
+    // one barrier per copied range, only ranges that continue each other are merged, the bytes in a gap were never
+    // written here and may belong to live data on another queue, so they must not take part in an ownership transfer
+    std::vector<VkBufferMemoryBarrier> buffer_barriers {};
+    for (const auto& copy : m_buffer_copies) {
+        if (!buffer_barriers.empty()) {
+            auto& last = buffer_barriers.back();
+            if (last.buffer == copy.dst && last.offset + last.size == copy.region.dstOffset) {
+                last.size += copy.region.size;
+                continue;
+            }
+        }
+
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.buffer = copy.dst;
+        barrier.offset = copy.region.dstOffset;
+        barrier.size = copy.region.size;
+        buffer_barriers.push_back(barrier);
+    }
+
+    // images that get mips stay in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL until the generator ran, they go last
+    // so the barriers that finish the other images are a prefix of the same array
+    const auto mip_images_begin = std::stable_partition(m_images.begin(), m_images.end(), [](const pending_image& image) {
+        return !image.generate_mips;
+    });
+    const auto finished_image_count = static_cast<uint32_t>(mip_images_begin - m_images.begin());
+
+    std::vector<VkImageMemoryBarrier> image_barriers {};
+    for (const auto& pending : m_images) {
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = pending.image.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = pending.image.mip_levels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = pending.image.array_layers;
+        image_barriers.push_back(barrier);
+    }
+
+    command_buffer_lists transfer_buffers {};
+    VkCommandPool transfer_vk_pool = p_device->acquire_command_pool(queue_type::transfer, command_pool_usage::transient, &transfer_buffers);
+    command_pool transfer_pool { p_device, transfer_vk_pool, queue_type::transfer, command_pool_usage::transient, std::move(transfer_buffers) };
+    auto transfer_list = transfer_pool.create_command_list();
+
+    transfer_list->begin_record(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    for (auto& barrier : image_barriers) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    }
+    transfer_list->pipeline_barrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        nullptr, 0,
+        image_barriers.data(), static_cast<uint32_t>(image_barriers.size()));
+
+    // regions that continue each other on both sides are merged into one
+    std::vector<VkBufferCopy> buffer_regions {};
+    for (std::size_t i = 0; i < m_buffer_copies.size(); i++) {
+        const auto& copy = m_buffer_copies[i];
+        if (!buffer_regions.empty()) {
+            auto& last = buffer_regions.back();
+            if (last.srcOffset + last.size == copy.region.srcOffset && last.dstOffset + last.size == copy.region.dstOffset) {
+                last.size += copy.region.size;
+            } else {
+                buffer_regions.push_back(copy.region);
+            }
+        } else {
+            buffer_regions.push_back(copy.region);
+        }
+
+        const bool last_of_group = i + 1 == m_buffer_copies.size() || m_buffer_copies[i + 1].dst != copy.dst || m_buffer_copies[i + 1].src != copy.src;
+        if (last_of_group) {
+            transfer_list->copy_buffer_to_buffer(copy.src, copy.dst, buffer_regions.data(), static_cast<uint32_t>(buffer_regions.size()));
+            buffer_regions.clear();
+        }
+    }
+
+    std::vector<VkBufferImageCopy> image_regions {};
+    for (std::size_t i = 0; i < m_image_copies.size(); i++) {
+        const auto& copy = m_image_copies[i];
+        image_regions.push_back(copy.region);
+
+        const bool last_of_group = i + 1 == m_image_copies.size() || m_image_copies[i + 1].dst != copy.dst || m_image_copies[i + 1].src != copy.src;
+        if (last_of_group) {
+            transfer_list->copy_buffer_to_image(copy.src, copy.dst, image_regions.data(), static_cast<uint32_t>(image_regions.size()));
+            image_regions.clear();
+        }
+    }
+
+    const uint32_t transfer_family = p_device->get_queue_family(queue_type::transfer);
+    const uint32_t graphics_family = p_device->get_queue_family(queue_type::graphics);
+
+    // without a dedicated transfer queue this list runs on the graphics queue and makes the data visible right here,
+    // otherwise it only releases ownership, the destination half of a release is ignored by the driver
+    for (auto& barrier : buffer_barriers) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dedicated_transfer ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+        barrier.srcQueueFamilyIndex = dedicated_transfer ? transfer_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = dedicated_transfer ? graphics_family : VK_QUEUE_FAMILY_IGNORED;
+    }
+    for (std::size_t i = 0; i < image_barriers.size(); i++) {
+        auto& barrier = image_barriers[i];
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dedicated_transfer ? 0 : VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = i < finished_image_count ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = dedicated_transfer ? transfer_family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = dedicated_transfer ? graphics_family : VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    // on the graphics queue the generator's own barriers pick up the copies into mip images
+    const auto released_image_count = dedicated_transfer ? static_cast<uint32_t>(image_barriers.size()) : finished_image_count;
+    transfer_list->pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, dedicated_transfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        buffer_barriers.data(), static_cast<uint32_t>(buffer_barriers.size()),
+        image_barriers.data(), released_image_count);
+
+    auto mips = m_manager->get_mip_generator();
+    if (!dedicated_transfer) {
+        for (auto pending = mip_images_begin; pending != m_images.end(); ++pending) {
+            mips->record(transfer_list.get(), pending->image, m_id);
+        }
+    }
+
+    transfer_list->end_record();
+
+    timeline_point point = transfer_list->submit();
+    if (!dedicated_transfer) {
+        mips->track_submit(m_id, point);
+    }
+
+    // staging memory is only read by the transfer list, so it can be reused as soon as that completes
+    m_manager->retire(m_id, point, std::move(m_dedicated_staging));
+    m_dedicated_staging.clear();
+
+    if (dedicated_transfer) {
+        command_buffer_lists graphics_buffers {};
+        VkCommandPool graphics_vk_pool = p_device->acquire_command_pool(queue_type::graphics, command_pool_usage::transient, &graphics_buffers);
+        command_pool graphics_pool { p_device, graphics_vk_pool, queue_type::graphics, command_pool_usage::transient, std::move(graphics_buffers) };
+        auto graphics_list = graphics_pool.create_command_list();
+
+        // the source half of an acquire is ignored by the driver, the semaphore wait provides the dependency
+        for (auto& barrier : buffer_barriers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        for (std::size_t i = 0; i < image_barriers.size(); i++) {
+            image_barriers[i].srcAccessMask = 0;
+            image_barriers[i].dstAccessMask = i < finished_image_count ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        }
+
+        graphics_list->begin_record(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        graphics_list->pipeline_barrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            buffer_barriers.data(), static_cast<uint32_t>(buffer_barriers.size()),
+            image_barriers.data(), static_cast<uint32_t>(image_barriers.size()));
+        for (auto pending = mip_images_begin; pending != m_images.end(); ++pending) {
+            mips->record(graphics_list.get(), pending->image, m_id);
+        }
+        graphics_list->end_record();
+
+        // the acquire barriers order every later graphics submission after the copies
+        submit_dependencies dependencies {};
+        dependencies.wait_for(point);
+
+        point = graphics_list->submit(&dependencies);
+        mips->track_submit(m_id, point);
+    }
+
+    m_buffer_copies.clear();
+    m_image_copies.clear();
+    m_images.clear();
+    m_last_submit = point;
+
+    return point;
+}
+
+upload_manager::upload_manager(weakref<device> p_device, VkDeviceSize ring_size, VkPipelineCache pipeline_cache)
+    : m_device(std::move(p_device))
+    , m_ring(m_device)
+    , m_ring_size(ring_size)
+    , m_mip_generator(m_device, pipeline_cache)
+{
+    m_ring.create_staging_buffer(m_ring_size);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->get_physical_device(), &properties);
+
+    // 16 covers the texel size of every uncompressed format with a power of two size and the block size of compressed ones
+    m_alignment = std::max(m_alignment, properties.limits.optimalBufferCopyOffsetAlignment);
+
+    m_batch = std::make_unique<upload_batch>(weakref<upload_manager>(this));
+}
+
+upload_manager::~upload_manager()
+{
+    m_batch.reset();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& region : m_regions) {
+        quix_assert(region.flushed, "an upload batch outlived the upload manager");
+        m_device->wait(region.point);
+    }
+    for (const auto& retired : m_retired_staging) {
+        m_device->wait(retired.point);
+    }
+}
+
+NODISCARD upload_batch upload_manager::create_batch()
+{
+    return upload_batch {
+        weakref<upload_manager>(this)
+    };
+}
+
+void upload_manager::upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+    m_batch->upload_buffer(dst, dst_offset, data, size);
+}
+
+void upload_manager::upload_image(image_handle* dst, const void* data, VkDeviceSize size, const VkBufferImageCopy* regions, uint32_t region_count)
+{
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+    m_batch->upload_image(dst, data, size, regions, region_count);
+}
+
+void upload_manager::generate_mips(image_handle* dst)
+{
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+    m_batch->generate_mips(dst);
+}
+
+timeline_point upload_manager::flush()
+{
+    std::lock_guard<std::mutex> lock(m_batch_mutex);
+    return m_batch->submit();
+}
+
+NODISCARD bool upload_manager::allocate(VkDeviceSize size, uint64_t batch, VkDeviceSize* offset)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    reclaim();
+
+    if (m_used == 0) {
+        m_head = 0;
+    }
+
+    VkDeviceSize begin = (m_head + m_alignment - 1) & ~(m_alignment - 1);
+    if (begin + size > m_ring_size) {
+        // the tail end of the ring is too short, skip it and wrap around
+        begin = 0;
+    }
+
+    const VkDeviceSize padding = begin >= m_head ? begin - m_head : m_ring_size - m_head;
+    if (m_used + padding + size > m_ring_size) {
+        return false;
+    }
+
+    m_regions.push_back(ring_region { padding + size, batch, {}, false });
+    m_used += padding + size;
+    m_head = begin + size;
+
+    *offset = begin;
+    return true;
+}
+
+void upload_manager::retire(uint64_t batch, timeline_point point, std::vector<std::unique_ptr<buffer_handle>>&& dedicated_staging)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& region : m_regions) {
+        if (region.batch == batch && !region.flushed) {
+            region.point = point;
+            region.flushed = true;
+        }
+    }
+
+    if (!dedicated_staging.empty()) {
+        m_retired_staging.push_back(retired_staging { point, std::move(dedicated_staging) });
+    }
+}
+
+void upload_manager::reclaim()
+{
+    while (!m_regions.empty() && m_regions.front().flushed && m_device->is_complete(m_regions.front().point)) {
+        m_used -= m_regions.front().size;
+        m_regions.pop_front();
+    }
+
+    while (!m_retired_staging.empty() && m_device->is_complete(m_retired_staging.front().point)) {
+        m_retired_staging.pop_front();
+    }
+}
+
+} // namespace quix
+
+#endif // _QUIX_UPLOAD_CPP
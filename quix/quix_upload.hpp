@@ -0,0 +1,161 @@
+#ifndef _QUIX_UPLOAD_HPP
+#define _QUIX_UPLOAD_HPP
+
+#include "quix_mipmap.hpp"
+#include "quix_resource.hpp"
+
+namespace quix {
+
+class device;
+class image_handle;
+class upload_manager;
+
+// collects any number of uploads and submits them at once, the transfer list gets one copy command per destination
+// carrying all of its regions and one barrier call on either side of the copies, a dedicated transfer queue adds one
+// graphics list that acquires everything with a single barrier call, a batch is meant to be filled from one thread,
+// copies are reordered by destination so uploads to overlapping ranges of one destination must go into separate batches
+class upload_batch {
+public:
+    explicit upload_batch(weakref<upload_manager> p_manager);
+    // anything still pending is submitted
+    ~upload_batch();
+
+    upload_batch(const upload_batch&) = delete;
+    upload_batch& operator=(const upload_batch&) = delete;
+    upload_batch(upload_batch&&) = delete;
+    upload_batch& operator=(upload_batch&&) = delete;
+
+    // data is copied into staging memory right away and may be freed on return, dst must have VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    void upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size);
+    // the bufferOffset of each region is relative to data, without regions data is the tightly packed first mip level of every layer,
+    // the whole image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, the batch keeps the VkImage and its description so
+    // dst may move but the image it holds has to stay alive until submit()
+    void upload_image(image_handle* dst, const void* data, VkDeviceSize size, const VkBufferImageCopy* regions = nullptr, uint32_t region_count = 0);
+    // same as the uploads above but the returned staging memory is written by the caller, e.g. read into straight from a file,
+    // it has to be filled before submit()
+    NODISCARD void* reserve_buffer(VkBuffer dst, VkDeviceSize dst_offset, VkDeviceSize size);
+    NODISCARD void* reserve_image(image_handle* dst, VkDeviceSize size, const VkBufferImageCopy* regions = nullptr, uint32_t region_count = 0);
+    // fills every level below the first from the uploaded first level on the graphics queue, dst has to be uploaded in this batch
+    // and created with a method the manager's mip generator supports
+    void generate_mips(image_handle* dst);
+
+    // graphics submissions made afterwards see the data without waiting on the returned point, other queues have to wait on it,
+    // returns the last submit when nothing is pending
+    timeline_point submit();
+
+    NODISCARD inline bool empty() const noexcept { return m_buffer_copies.empty() && m_image_copies.empty(); }
+    NODISCARD inline timeline_point get_last_submit() const noexcept { return m_last_submit; }
+    NODISCARD inline weakref<upload_manager> get_manager() const noexcept { return m_manager; }
+
+private:
+    struct staging_range {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* mapped = nullptr;
+    };
+
+    struct pending_buffer_copy {
+        VkBuffer src = VK_NULL_HANDLE;
+        VkBuffer dst = VK_NULL_HANDLE;
+        VkBufferCopy region {};
+    };
+
+    struct pending_image_copy {
+        VkBuffer src = VK_NULL_HANDLE;
+        VkImage dst = VK_NULL_HANDLE;
+        VkBufferImageCopy region {};
+    };
+
+    // captured on the first upload, submit() never goes back to the image_handle
+    struct pending_image {
+        mip_image image {};
+        bool generate_mips = false;
+    };
+
+    NODISCARD staging_range stage(VkDeviceSize size);
+    void track_image(const image_handle* dst);
+
+    weakref<upload_manager> m_manager;
+    uint64_t m_id;
+
+    std::vector<pending_buffer_copy> m_buffer_copies {};
+    std::vector<pending_image_copy> m_image_copies {};
+    std::vector<pending_image> m_images {};
+    // uploads that did not fit into the ring, handed to the manager on submit and freed once the copies completed
+    std::vector<std::unique_ptr<buffer_handle>> m_dedicated_staging {};
+
+    timeline_point m_last_submit {};
+};
+
+// owns one persistently mapped staging ring that batches sub-allocate from, ring space is handed back once the submission
+// that read it has completed, an exhausted ring never makes anyone wait, the upload gets a dedicated staging buffer instead
+class upload_manager {
+    friend class upload_batch;
+
+public:
+    static constexpr VkDeviceSize default_ring_size = 32 * 1024 * 1024;
+
+    // pipeline_cache goes to the mip generator
+    upload_manager(weakref<device> p_device, VkDeviceSize ring_size = default_ring_size, VkPipelineCache pipeline_cache = VK_NULL_HANDLE);
+    ~upload_manager();
+
+    upload_manager(const upload_manager&) = delete;
+    upload_manager& operator=(const upload_manager&) = delete;
+    upload_manager(upload_manager&&) = delete;
+    upload_manager& operator=(upload_manager&&) = delete;
+
+    // batches have to be submitted or dropped before the manager
+    NODISCARD upload_batch create_batch();
+
+    // shared batch behind create_staged_buffer and create_image_from_file, safe to use from several threads
+    void upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size);
+    void upload_image(image_handle* dst, const void* data, VkDeviceSize size, const VkBufferImageCopy* regions = nullptr, uint32_t region_count = 0);
+    void generate_mips(image_handle* dst);
+    timeline_point flush();
+
+    NODISCARD inline VkDeviceSize get_ring_size() const noexcept { return m_ring_size; }
+    NODISCARD inline weakref<mip_generator> get_mip_generator() noexcept { return weakref<mip_generator>(&m_mip_generator); }
+
+private:
+    NODISCARD bool allocate(VkDeviceSize size, uint64_t batch, VkDeviceSize* offset);
+    void retire(uint64_t batch, timeline_point point, std::vector<std::unique_ptr<buffer_handle>>&& dedicated_staging);
+    void reclaim();
+
+    NODISCARD inline uint64_t next_batch_id() noexcept { return m_next_batch_id.fetch_add(1, std::memory_order_relaxed); }
+
+    // size includes the padding skipped in front of the allocation, point is only valid once flushed
+    struct ring_region {
+        VkDeviceSize size = 0;
+        uint64_t batch = 0;
+        timeline_point point {};
+        bool flushed = false;
+    };
+
+    struct retired_staging {
+        timeline_point point {};
+        std::vector<std::unique_ptr<buffer_handle>> buffers {};
+    };
+
+    weakref<device> m_device;
+    buffer_handle m_ring;
+    VkDeviceSize m_ring_size;
+    VkDeviceSize m_alignment = 16;
+
+    std::mutex m_mutex;
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_used = 0;
+    // oldest first, a region of a batch that has not been submitted yet holds back everything after it
+    std::deque<ring_region> m_regions {};
+    std::deque<retired_staging> m_retired_staging {};
+    std::atomic<uint64_t> m_next_batch_id { 1 };
+
+    // declared before the shared batch so its last submit can still record mips
+    mip_generator m_mip_generator;
+
+    std::mutex m_batch_mutex;
+    std::unique_ptr<upload_batch> m_batch;
+};
+
+} // namespace quix
+
+#endif // _QUIX_UPLOAD_HPP
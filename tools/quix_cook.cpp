@@ -0,0 +1,150 @@
+// offline cooker, turns loose assets into a pack that is uploaded without any decoding at runtime
+//
+//     quix_cook <output pack> <asset>...
+//
+// ktx2 and dds files keep their stored format and mips, images stb can decode become rgba8 srgb with a full mip chain
+// filtered on the cpu, anything else is stored as a raw buffer, assets are named by the path they were given as
+
+#include "quix_asset_pack.hpp"
+#include "quix_mipmap.hpp"
+#include "quix_texture_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+bool is_decodable_image(const char* filepath)
+{
+    int width {};
+    int height {};
+    int channels {};
+    return stbi_info(filepath, &width, &height, &channels) != 0;
+}
+
+float srgb_to_linear(uint8_t value)
+{
+    const float normalized = static_cast<float>(value) / 255.0f;
+    return normalized <= 0.04045f ? normalized / 12.92f : std::pow((normalized + 0.055f) / 1.055f, 2.4f);
+}
+
+uint8_t linear_to_srgb(float value)
+{
+    const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::clamp(encoded, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// 2x2 box filter, color is averaged in linear space and alpha as it is, odd edges repeat their last texel
+void downsample(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst, uint32_t dst_width, uint32_t dst_height)
+{
+    for (uint32_t y = 0; y < dst_height; y++) {
+        for (uint32_t x = 0; x < dst_width; x++) {
+            const uint32_t x0 = std::min(x * 2, src_width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, src_width - 1);
+            const uint32_t y0 = std::min(y * 2, src_height - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, src_height - 1);
+            const std::array<const uint8_t*, 4> texels = {
+                src + (y0 * src_width + x0) * 4,
+                src + (y0 * src_width + x1) * 4,
+                src + (y1 * src_width + x0) * 4,
+                src + (y1 * src_width + x1) * 4,
+            };
+
+            uint8_t* out = dst + (y * dst_width + x) * 4;
+            for (uint32_t channel = 0; channel < 3; channel++) {
+                float sum = 0.0f;
+                for (const uint8_t* texel : texels) {
+                    sum += srgb_to_linear(texel[channel]);
+                }
+                out[channel] = linear_to_srgb(sum / 4.0f);
+            }
+
+            uint32_t alpha = 0;
+            for (const uint8_t* texel : texels) {
+                alpha += texel[3];
+            }
+            out[3] = static_cast<uint8_t>((alpha + 2) / 4);
+        }
+    }
+}
+
+void cook_image(quix::asset_pack_writer* writer, const char* filepath)
+{
+    int width {};
+    int height {};
+    int channels {};
+    stbi_uc* pixels = stbi_load(filepath, &width, &height, &channels, STBI_rgb_alpha);
+    quix_assert(pixels != nullptr, fmt::format("failed to load image {}: {}", filepath, stbi_failure_reason()));
+
+    const VkExtent3D extent { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+    const uint32_t mip_levels = quix::get_full_mip_count(extent);
+
+    std::vector<VkBufferImageCopy> regions(mip_levels);
+    VkDeviceSize size = 0;
+    for (uint32_t level = 0; level < mip_levels; level++) {
+        auto& region = regions[level];
+        region.bufferOffset = size;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), 1 };
+
+        // keeps every level on the 16 byte alignment the upload ring hands out
+        size += (VkDeviceSize { region.imageExtent.width } * region.imageExtent.height * 4 + 15) & ~VkDeviceSize { 15 };
+    }
+
+    std::vector<uint8_t> data(size);
+    std::memcpy(data.data(), pixels, VkDeviceSize { extent.width } * extent.height * 4);
+    stbi_image_free(pixels);
+
+    for (uint32_t level = 1; level < mip_levels; level++) {
+        const auto& src = regions[level - 1];
+        const auto& dst = regions[level];
+        downsample(data.data() + src.bufferOffset, src.imageExtent.width, src.imageExtent.height,
+            data.data() + dst.bufferOffset, dst.imageExtent.width, dst.imageExtent.height);
+    }
+
+    writer->add_texture(filepath, VK_FORMAT_R8G8B8A8_SRGB, extent, mip_levels, data.data(), size, regions.data(), mip_levels);
+}
+
+void cook_container(quix::asset_pack_writer* writer, const char* filepath)
+{
+    const quix::texture_file file = quix::load_texture_file(filepath);
+    writer->add_texture(filepath, file.format, file.extent, file.mip_levels,
+        file.get_payload(), file.payload_size, file.regions.data(), static_cast<uint32_t>(file.regions.size()));
+}
+
+void cook_buffer(quix::asset_pack_writer* writer, const char* filepath)
+{
+    const std::vector<char> contents = quix::read_texture_bytes(filepath);
+    writer->add_buffer(filepath, contents.data(), contents.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        fmt::print("usage: {} <output pack> <asset>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    quix::asset_pack_writer writer {};
+    for (int i = 2; i < argc; i++) {
+        const char* filepath = argv[i];
+        quix_assert(std::filesystem::is_regular_file(filepath), fmt::format("{} does not exist", filepath));
+
+        if (quix::is_texture_container(filepath)) {
+            cook_container(&writer, filepath);
+        } else if (is_decodable_image(filepath)) {
+            cook_image(&writer, filepath);
+        } else {
+            cook_buffer(&writer, filepath);
+        }
+    }
+
+    writer.write(argv[1]);
+    fmt::print("cooked {} assets into {}\n", argc - 2, argv[1]);
+
+    return EXIT_SUCCESS;
+}